@@ -28,6 +28,9 @@
 #include "qtvp_global.h"
 #include "vpgc.h"
 
+// Forward declarations.
+class VpDeadline;
+
 class QTVPSHARED_EXPORT GridGC
 {
   public:
@@ -47,6 +50,9 @@ class QTVPSHARED_EXPORT GridGC
     int   m_ynum;
     int   m_dx;
     int   m_dy;
+    double m_opacity;
+    // Drawing stops early once this expires; may be null.
+    VpDeadline *m_deadline;
 };
 
 #endif // __GRIDGC_H_
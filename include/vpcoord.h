@@ -24,12 +24,22 @@
 #ifndef __VPCOORD_H_
 #define __VPCOORD_H_
 
+// Include Qt header files.
+#include <QString>
+
 // Include QtVp header files.
 #include "qtvp_global.h"
 #include "vptypes.h"
-
-class QString;
-
+#include "vppoint.h"
+
+/**
+ * The <code>VpCoord</code> class is a named three dimensional coordinate.
+ * <p>
+ * It wraps a <code>VpPoint</code> with a z component and the name of its
+ * viewport. Hot paths should pass <code>VpPoint</code> instead; unlike the
+ * name, it never needs reference counting.
+ * </p>
+ */
 class QTVPSHARED_EXPORT VpCoord
 {
   public:
@@ -48,11 +58,12 @@ class QTVPSHARED_EXPORT VpCoord
     explicit VpCoord(int x = 0, int y = 0, int z = 0);
 
     /**
-     * @brief Copy constructor
+     * A constructor that specifies the point and the viewport name.
      *
-     * @param coord The <code>AuCoord</code> to copy.
+     * @param point The x and y components of the coordinate.
+     * @param name The name of the associated viewport.
      */
-    VpCoord(const VpCoord &coord);
+    VpCoord(const VpPoint &point, const QString &name);
 
     /**
      * @brief The destructor.
@@ -69,7 +80,7 @@ class QTVPSHARED_EXPORT VpCoord
      * @return An integer is returned representing the value of the x component
      * in world coordinate space.
      */
-    int getX() { return m_x; }
+    int getX() const { return m_point.m_x; }
 
     /**
      * Set the x component of the coordinate.
@@ -77,7 +88,7 @@ class QTVPSHARED_EXPORT VpCoord
      * @param value An integer representing the value of the x component
      * in world coordinate space.
      */
-    void setX(const int value) { m_x = value; }
+    void setX(const int value) { m_point.m_x = value; }
 
     /**
      * Get the y component of the coordinate.
@@ -85,7 +96,7 @@ class QTVPSHARED_EXPORT VpCoord
      * @return An integer is returned representing the value of the y component
      * in world coordinate space.
      */
-    int getY() { return m_y; }
+    int getY() const { return m_point.m_y; }
 
     /**
      * Set the y component of the coordinate.
@@ -93,7 +104,7 @@ class QTVPSHARED_EXPORT VpCoord
      * @param value An integer representing the value of the y component
      * in world coordinate space.
      */
-    void setY(const int value) { m_y = value; }
+    void setY(const int value) { m_point.m_y = value; }
 
     /**
      * Get the z component of the coordinate.
@@ -101,7 +112,7 @@ class QTVPSHARED_EXPORT VpCoord
      * @return An integer is returned representing the value of the z component
      * in world coordinate space.
      */
-    int getZ() { return m_z; }
+    int getZ() const { return m_z; }
 
     /**
      * Set the z component of the coordinate.
@@ -111,26 +122,29 @@ class QTVPSHARED_EXPORT VpCoord
      */
     void setZ(const int value) { m_z = value; }
 
-    QString getName() { return m_name; }
+    QString getName() const { return m_name; }
 
     void setName(const QString name) { m_name = name; }
 
     /**
-     * Formats the coordinate as (x,y,z,vpname).
-     *
-     * @return A String is returned, formatting the contents of the VpCoord
-     * suitable for display.
+     * Get the x and y components of the coordinate.
      */
-    const QString toString();
+    const VpPoint &getPoint() const { return m_point; }
 
     /**
-     * @brief Assigns a copy of AuCoord to this coord, and returns a reference to it.
+     * Set the x and y components of the coordinate.
      *
-     * @param coord The <code>AuCoord</code> to assign.
+     * @param point The new x and y components.
+     */
+    void setPoint(const VpPoint &point) { m_point = point; }
+
+    /**
+     * Formats the coordinate as (x,y,z,vpname).
      *
-     * @return A reference to <b>this</b> coord is returned.
+     * @return A String is returned, formatting the contents of the VpCoord
+     * suitable for display.
      */
-    VpCoord & operator=(const VpCoord & coord);
+    const QString toString();
 
     /**
      * @brief Equality operator.
@@ -174,10 +188,8 @@ class QTVPSHARED_EXPORT VpCoord
 
   protected:
 
-    /** The x component of the coordinate. Defaults to <b>0</b>. */
-    int m_x;
-    /** The y component of the coordinate. Defaults to <b>0</b>. */
-    int m_y;
+    /** The x and y components of the coordinate. Default to <b>0</b>. */
+    VpPoint m_point;
     /** The z component of the coordinate. Defaults to <b>0</b>. */
     int m_z;
     /** The name of the associated <code>Viewport</code>. */
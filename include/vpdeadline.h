@@ -0,0 +1,90 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+#ifndef __VPDEADLINE_H_
+#define __VPDEADLINE_H_
+
+// Include Qt header files.
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+
+/**
+ * The <code>VpDeadline</code> class tells long drawing loops when to stop.
+ * <p>
+ * A deadline expires once its time budget is spent or it is cancelled.
+ * Loops poll <code>hasExpired()</code> between units of work, such as the
+ * rows of a grid; once it has returned <b>true</b> the deadline stays
+ * expired and <code>isStopped()</code> tells the caller that the work was
+ * left incomplete. <code>cancel()</code> may be called from any thread.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpDeadline
+{
+  public:
+
+    /**
+     * @brief Default constructor. Creates a deadline that never expires.
+     */
+    VpDeadline();
+
+    /**
+     * Restart the deadline.
+     *
+     * @param budget The time budget, in milliseconds. A budget of 0 or
+     * less never expires, unless the deadline is cancelled.
+     */
+    void start(int budget);
+
+    /**
+     * Cancel the deadline; it expires at the next poll.
+     */
+    void cancel();
+
+    /**
+     * Determine whether the work must stop.
+     *
+     * @return <b>true</b> is returned if the deadline has been cancelled
+     * or its budget is spent. Otherwise, <b>false</b> is returned.
+     */
+    bool hasExpired();
+
+    /**
+     * Determine whether <code>hasExpired()</code> has returned <b>true</b>
+     * since the deadline was started.
+     */
+    bool isStopped() const { return m_stopped; }
+
+  private:
+
+    QElapsedTimer m_timer;
+    qint64 m_budget;
+    QAtomicInt m_cancelled;
+    bool m_stopped;
+};
+
+#endif // __VPDEADLINE_H_
@@ -0,0 +1,422 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+#ifndef __VPDISPLAYLIST_H_
+#define __VPDISPLAYLIST_H_
+
+// Include Qt header files.
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <QLineF>
+#include <QPolygonF>
+#include <QString>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+#include "vpspatialindex.h"
+
+// Forward declarations.
+class QPainter;
+class QTransform;
+
+/**
+ * The <code>VpDisplayStyle</code> describes how display list items are
+ * drawn. Pens are cosmetic, so line widths are in pixels whatever the zoom.
+ */
+struct QTVPSHARED_EXPORT VpDisplayStyle
+{
+    // Marker shapes.
+    enum Marker { MARKER_SQUARE, MARKER_CIRCLE, MARKER_CROSS };
+
+    VpDisplayStyle();
+
+    QPen   m_pen;
+    QBrush m_brush;
+    QFont  m_font;
+    Marker m_marker;
+    // The width and height of a marker, in pixels.
+    int    m_markerSize;
+};
+
+/**
+ * The <code>VpDisplayList</code> class retains world coordinate primitives
+ * for a <code>VpGraphics2D</code>, which renders them after the grid.
+ * <p>
+ * Items are kept in structure-of-arrays form: one array per attribute,
+ * indexed by slot, with all vertices in a single shared pool. Each item is
+ * identified by a handle combining its slot with a generation count, so a
+ * handle stays valid until its item is removed and is never confused with
+ * a later item that reuses the slot. Removed slots are recycled.
+ * </p>
+ * <p>
+ * Text and markers are anchored at a world coordinate but sized in pixels.
+ * </p>
+ * <p>
+ * The bounding boxes of the items are kept in a spatial index, so drawing
+ * and queries only visit the items near the area of interest.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpDisplayList : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    // Item types.
+    enum Type { ITEM_NONE, ITEM_LINE, ITEM_POLYLINE, ITEM_RECT, ITEM_POLYGON, ITEM_TEXT, ITEM_MARKER };
+
+    // A stable item identifier; 0 is never a valid handle.
+    typedef quint64 Handle;
+
+    // Distance beyond the drawn area within which text and marker anchors
+    // are still drawn, in pixels. Text and markers are culled by their
+    // anchor alone, so this also bounds how far they may reach from it.
+    static const int ANCHOR_MARGIN = 64;
+
+    explicit VpDisplayList(QObject *parent = 0);
+
+    /**
+     * @brief The destructor.
+     */
+    virtual ~VpDisplayList();
+
+    /**
+     * Add a style.
+     *
+     * @param style The style. Its pen is made cosmetic.
+     *
+     * @return The style handle is returned.
+     */
+    int addStyle(const VpDisplayStyle &style);
+
+    /**
+     * Replace a style; every item using it is redrawn with the new style.
+     *
+     * @param id The style handle.
+     * @param style The new style. Its pen is made cosmetic.
+     *
+     * @return <b>true</b> is returned if the style exists. Otherwise,
+     * <b>false</b> is returned.
+     */
+    bool setStyle(int id, const VpDisplayStyle &style);
+
+    /**
+     * Get a style.
+     *
+     * @param id The style handle.
+     */
+    const VpDisplayStyle &getStyle(int id) const { return m_styles.at(id); }
+
+    /**
+     * Get the number of styles.
+     */
+    int getStyleCount() const { return m_styles.size(); }
+
+    // Add items; each returns the handle of the new item.
+    Handle addLine(const QPointF &p1, const QPointF &p2, int style);
+    Handle addPolyline(const QPolygonF &points, int style);
+    Handle addRect(const QRectF &rect, int style);
+    Handle addPolygon(const QPolygonF &points, int style);
+    Handle addMarker(const QPointF &anchor, int style);
+
+    /**
+     * Add a text item. The text is drawn in device space from its anchor,
+     * and is culled by the anchor alone; a label extending more than
+     * ANCHOR_MARGIN pixels from its anchor may disappear while part of it
+     * is still within the drawn area. Split longer labels into several
+     * items.
+     *
+     * @param anchor The anchor, in world coordinates.
+     * @param text The text to draw.
+     * @param style The style identifier.
+     *
+     * @return The handle of the new item.
+     */
+    Handle addText(const QPointF &anchor, const QString &text, int style);
+
+    /**
+     * Replace the vertices of an item. Lines take two points, rectangles
+     * two opposite corners, and text and markers their anchor.
+     *
+     * @param item The item handle.
+     * @param points The new vertices.
+     *
+     * @return <b>true</b> is returned if the item exists and the number of
+     * points suits its type. Otherwise, <b>false</b> is returned.
+     */
+    bool setPoints(Handle item, const QPolygonF &points);
+
+    /**
+     * Replace the string of a text item.
+     *
+     * @param item The item handle.
+     * @param text The new string.
+     *
+     * @return <b>true</b> is returned if the item is a text item.
+     * Otherwise, <b>false</b> is returned.
+     */
+    bool setText(Handle item, const QString &text);
+
+    /**
+     * Change the style of an item.
+     *
+     * @param item The item handle.
+     * @param style The style handle.
+     *
+     * @return <b>true</b> is returned if the item and style exist.
+     * Otherwise, <b>false</b> is returned.
+     */
+    bool setItemStyle(Handle item, int style);
+
+    /**
+     * Remove an item. Its handle becomes invalid.
+     *
+     * @param item The item handle.
+     *
+     * @return <b>true</b> is returned if the item existed. Otherwise,
+     * <b>false</b> is returned.
+     */
+    bool remove(Handle item);
+
+    /**
+     * @brief Remove all items. Styles are kept.
+     */
+    void clear();
+
+    /**
+     * Determine whether a handle refers to an existing item.
+     *
+     * @param item The item handle.
+     */
+    bool isValid(Handle item) const;
+
+    /**
+     * Get the number of items.
+     */
+    int getCount() const { return m_itemCount; }
+
+    /**
+     * Make this list a copy of another, without signalling a change.
+     * <p>
+     * The storage is implicitly shared, so copying is cheap and whichever
+     * list is changed next detaches. A copy may be drawn on another thread
+     * while the original is edited on the GUI thread.
+     * </p>
+     *
+     * @param list The list to copy.
+     */
+    void copy(const VpDisplayList &list);
+
+    /**
+     * Remove all items, without signalling a change, and drop this list's
+     * share of the item storage. A list this one was copied from can then
+     * be edited without detaching. Unlike <code>clear()</code>, the slots
+     * are dropped too, so handles may be reissued; this is meant for
+     * copies that are done with. Styles are kept.
+     */
+    void release();
+
+    /**
+     * Get the type of an item, or <code>ITEM_NONE</code> if the handle is
+     * not valid.
+     *
+     * @param item The item handle.
+     */
+    Type getType(Handle item) const;
+
+    /**
+     * Get the world coordinate bounding box of an item. Text and markers
+     * are bounded by their anchor.
+     *
+     * @param item The item handle.
+     */
+    QRectF getBounds(Handle item) const;
+
+    /**
+     * Find the items whose bounding boxes intersect a world coordinate
+     * rectangle. Text and markers are found by their anchor.
+     *
+     * @param rect The query rectangle.
+     * @param items The handles of the items found are appended to this.
+     */
+    void query(const QRectF &rect, QVector<Handle> *items);
+
+    /**
+     * Select the items that meet a world coordinate rectangle.
+     * <p>
+     * When selecting by intersection, lines and polylines are tested
+     * segment by segment and polygons by their outline and interior, so an
+     * item is only selected if its geometry, not merely its bounding box,
+     * meets the rectangle. Rectangles are treated as areas, and text and
+     * markers as their anchor.
+     * </p>
+     *
+     * @param rect The selection rectangle.
+     * @param contained If <b>true</b>, select only the items lying entirely
+     * within the rectangle. Otherwise, select the items that intersect it.
+     * @param items The handles of the items selected are appended to this.
+     */
+    void select(const QRectF &rect, bool contained, QVector<Handle> *items);
+
+    /**
+     * Find the item nearest a world coordinate point, within a distance
+     * measured in device pixels.
+     * <p>
+     * Distances are exact: to the nearest segment of lines, polylines and
+     * outlines, and zero inside rectangles, polygons and markers. Text is
+     * measured to its anchor. Of equally near items, the one drawn last
+     * is returned.
+     * </p>
+     *
+     * @param point The world coordinate point.
+     * @param tolerance The largest distance, in pixels.
+     * @param matrix The world to device transform the items are drawn with.
+     *
+     * @return The handle of the nearest item is returned, or 0 if no item
+     * is within the tolerance.
+     */
+    Handle pick(const QPointF &point, int tolerance, const QTransform &matrix);
+
+    /**
+     * Rebuild the spatial index from scratch. The index is maintained
+     * incrementally; rebuilding it after adding many items at once packs
+     * it more tightly and makes queries faster.
+     */
+    void rebuildIndex();
+
+    /**
+     * Draw the items that may be visible within a world coordinate
+     * rectangle, in slot order. A new item may take the slot of a removed
+     * one.
+     *
+     * @param gc The painter. Its world transform is replaced.
+     * @param matrix The world to device transform.
+     * @param clip The world coordinate rectangle being drawn.
+     */
+    void draw(QPainter *gc, const QTransform &matrix, const QRectF &clip);
+
+  signals:
+
+    /**
+     * @brief Signal that items or styles have changed.
+     */
+    void changed();
+
+  protected:
+
+    /**
+     * Allocate a slot for a new item.
+     *
+     * @return The slot is returned.
+     */
+    int allocate(Type type, int style, const QPointF *points, int count);
+
+    /**
+     * Store the vertices of a slot, reusing its pool space if they fit.
+     */
+    void storePoints(int slot, const QPointF *points, int count);
+
+    /**
+     * Compact the vertex pool once enough of it is unused.
+     */
+    void compact();
+
+    /**
+     * Get the slot of a valid handle, or -1.
+     */
+    int slotOf(Handle item) const;
+
+    /**
+     * Get the handle of the item in a slot.
+     */
+    Handle handleOf(int slot) const { return ((Handle) m_generations.at(slot) << 32) | (Handle) slot; }
+
+    /**
+     * Determine whether the geometry of a slot meets a rectangle.
+     */
+    bool intersects(int slot, double xmin, double ymin, double xmax, double ymax) const;
+
+    /**
+     * Get the square of the device distance from a point to the geometry
+     * of a slot.
+     *
+     * @param slot The slot.
+     * @param point The world coordinate point.
+     * @param sx The x scale from world to device.
+     * @param sy The y scale from world to device.
+     */
+    double distance2(int slot, const QPointF &point, double sx, double sy) const;
+
+    /**
+     * Draw the specified slots, batching consecutive lines of a style.
+     */
+    void drawSlots(QPainter *gc, const QTransform &matrix, const int *visible, int count);
+
+  protected:
+
+    // Per slot attributes.
+    QVector<quint8>  m_types;
+    QVector<quint32> m_generations;
+    QVector<int>     m_styleIds;
+    QVector<double>  m_xmin;
+    QVector<double>  m_ymin;
+    QVector<double>  m_xmax;
+    QVector<double>  m_ymax;
+    QVector<int>     m_first;
+    QVector<int>     m_count;
+
+    // The shared vertex pool.
+    QVector<QPointF> m_points;
+    // Pool entries no longer used by any item.
+    int m_garbage;
+
+    // The bounding boxes of the items, by slot.
+    VpSpatialIndex m_index;
+
+    // The strings of text items, by slot.
+    QHash<int, QString> m_texts;
+
+    // Slots free for reuse.
+    QVector<int> m_free;
+    // The number of items.
+    int m_itemCount;
+
+    QVector<VpDisplayStyle> m_styles;
+
+    // Reusable buffers for drawing.
+    QVector<int>    m_visible;
+    QVector<QLineF> m_lines;
+    // A reusable buffer for picking, queries and selection.
+    QVector<int>    m_hits;
+};
+
+#endif // __VPDISPLAYLIST_H_
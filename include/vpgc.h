@@ -24,12 +24,16 @@
 #ifndef __VPGC_H_
 #define __VPGC_H_
 
+// Include Qt header files.
+#include <QRect>
+
 // Include QtVp header files.
 #include "qtvp_global.h"
 
 // Forward declarations.
 class QPainter;
 class VpViewport;
+class VpDeadline;
 
 class QTVPSHARED_EXPORT VpGC
 {
@@ -74,6 +78,37 @@ class QTVPSHARED_EXPORT VpGC
      */
     void setGC(QPainter *gc) { m_gc = gc; }
 
+    /**
+     * @brief Get the device rectangle that drawing is restricted to.
+     *
+     * @return The clip rectangle is returned. A null rectangle means the
+     * whole viewport is drawn.
+     */
+    const QRect &getClipRect() { return m_clipRect; }
+
+    /**
+     * @brief Restrict drawing to a device rectangle.
+     *
+     * @param rect The clip rectangle, in device coordinates. A null rectangle
+     * means the whole viewport is drawn.
+     */
+    void setClipRect(const QRect &rect) { m_clipRect = rect; }
+
+    /**
+     * @brief Get the deadline long drawing operations stop at.
+     *
+     * @return The deadline is returned. May be <b>null</b>.
+     */
+    VpDeadline *getDeadline() { return m_deadline; }
+
+    /**
+     * @brief Set the deadline long drawing operations stop at.
+     *
+     * @param deadline The deadline. If <b>null</b>, drawing always runs to
+     * completion.
+     */
+    void setDeadline(VpDeadline *deadline) { m_deadline = deadline; }
+
   protected:
 
     /** The <code>AuViewport</code> associated with this graphics context. */
@@ -81,6 +116,12 @@ class QTVPSHARED_EXPORT VpGC
 
     /** The Qt painter context associated with this viewport. */
     QPainter *m_gc;
+
+    /** The device rectangle drawing is restricted to. */
+    QRect m_clipRect;
+
+    /** The deadline long drawing operations stop at. */
+    VpDeadline *m_deadline;
 };
 
 #endif // __VPGC_H_
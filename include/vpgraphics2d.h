@@ -26,23 +26,46 @@
 
 // Include Qt header files.
 #include <QObject>
+#include <QPixmap>
+#include <QImage>
+#include <QRegion>
+#include <QAtomicInt>
+#include <QTransform>
+#include <QBasicTimer>
 
 // Include QtVp header files.
 #include "qtvp_global.h"
 #include "vptypes.h"
 #include "vpcoord.h"
+#include "vppoint.h"
 #include "vpgrid.h"
 #include "vpviewport.h"
 #include "vpgc.h"
+#include "vpdeadline.h"
+#include "vptransform.h"
+#include "vpgridlayout.h"
+#include "vpdisplaylist.h"
 
 // Forward declarations.
 class QRect;
 class QPoint;
+class QPointF;
 class QRubberBand;
+class VpGridTileCache;
+class VpRenderThread;
 
 /**
  * The <code>VpGraphics2D</code> class is a base class used for managing the coordinate
  * space of a 2-dimensional graphics viewport.
+ * <p>
+ * Threading model: a viewport is owned by the GUI thread and all of its
+ * methods, painting included, must be called from that thread; no locking
+ * is done. The one exception is <code>getTransform()</code>, which may be
+ * called from any thread to obtain a consistent snapshot of the current
+ * world to device mapping without blocking the GUI thread. The mapping
+ * is published by a sequence lock that assumes a single writer, the GUI
+ * thread.
+ * </p>
  *
  * @author Mark S. Millard
  */
@@ -52,6 +75,34 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
 
   public:
 
+    // World coordinate modes.
+    enum CoordMode { COORD_INT, COORD_DOUBLE };
+
+    // Rubber-band selection modes. Selecting by direction selects the
+    // items contained in the band when it is dragged to the right, and
+    // the items it intersects when it is dragged to the left.
+    enum SelectionMode { SELECT_BY_DIRECTION, SELECT_INTERSECTS, SELECT_CONTAINS };
+
+    // Rendering modes. Direct rendering draws on the GUI thread when the
+    // view is painted; threaded rendering rasterizes on a worker thread.
+    enum RenderMode { RENDER_DIRECT, RENDER_THREADED };
+
+    // A level of detail of the grid as drawn: its spacing, in world
+    // coordinates, and its opacity.
+    struct GridLevel
+    {
+        int    m_dx;
+        int    m_dy;
+        double m_opacity;
+    };
+
+    // The default hit-test tolerance, in pixels.
+    static const int DEFAULT_HIT_TOLERANCE = 3;
+
+    // The interval between processed mouse moves, in milliseconds; one
+    // frame of a 60 Hz display.
+    static const int MOUSE_MOVE_INTERVAL = 16;
+
     explicit VpGraphics2D(QWidget *parent = 0);
 
     /**
@@ -82,7 +133,101 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
     float getPixelHeight() { return m_2dPixelHeight; }
     void setPixelHeight(float value) { m_2dPixelHeight= value; }
     VpGrid *getGrid() { return m_2dGrid; }
-    void setGrid(VpGrid *grid) { m_2dGrid = grid; }
+    void setGrid(VpGrid *grid) { m_2dGrid = grid; invalidate(); }
+    VpGridTileCache *getGridTileCache() { return m_gridTileCache; }
+
+    /**
+     * Get the display list of world coordinate primitives drawn over the
+     * grid. The viewport owns the list and redraws whenever it changes.
+     */
+    VpDisplayList *getDisplayList() { return m_displayList; }
+
+    // Accessors for the double precision mapping. In COORD_INT mode the
+    // extent holds the same whole values as the integer accessors.
+    double getWxminF() { return m_2dWxminF; }
+    void setWxminF(double value) { m_2dWxminF = value; }
+    double getWyminF() { return m_2dWyminF; }
+    void setWyminF(double value) { m_2dWyminF = value; }
+    double getWxmaxF() { return m_2dWxmaxF; }
+    void setWxmaxF(double value) { m_2dWxmaxF = value; }
+    double getWymaxF() { return m_2dWymaxF; }
+    void setWymaxF(double value) { m_2dWymaxF = value; }
+    double getXScaleF() { return m_2dXScaleF; }
+    void setXScaleF(double value) { m_2dXScaleF = value; }
+    double getYScaleF() { return m_2dYScaleF; }
+    void setYScaleF(double value) { m_2dYScaleF = value; }
+    double getXOffsetF() { return m_2dXOffsetF; }
+    void setXOffsetF(double value) { m_2dXOffsetF = value; }
+    double getYOffsetF() { return m_2dYOffsetF; }
+    void setYOffsetF(double value) { m_2dYOffsetF = value; }
+    float getXInvScale() { return m_2dXInvScale; }
+    float getYInvScale() { return m_2dYInvScale; }
+
+    /**
+     * Get the cached world to device matrix. It is recomputed whenever the
+     * extent is set or panned, and is the matrix the viewport paints with.
+     */
+    const QTransform &getWorldToDevMatrix() { return m_worldToDevMatrix; }
+
+    /**
+     * Get the cached device to world matrix, the inverse of
+     * <code>getWorldToDevMatrix()</code>. Picking through it is consistent
+     * with what was painted.
+     */
+    const QTransform &getDevToWorldMatrix() { return m_devToWorldMatrix; }
+
+    /**
+     * Get the world coordinate mode.
+     */
+    CoordMode getCoordMode() { return m_coordMode; }
+
+    /**
+     * Set the world coordinate mode. The mode applies from the next call
+     * to <code>setWorldCoords()</code>.
+     * <p>
+     * In <code>COORD_INT</code> mode the world extent must fit in an
+     * <code>int</code> and integer coordinates are mapped through the
+     * painting matrices and rounded, exactly as the batched kernels do. In
+     * <code>COORD_DOUBLE</code> mode the extent may span up to
+     * <code>MAX_WC_EXTENT_F</code> (the range of exact integers in a
+     * double), all mappings use double precision, and the integer extent
+     * accessors saturate at <code>MAX_WC_EXTENT</code>.
+     * </p>
+     *
+     * @param mode The coordinate mode.
+     */
+    void setCoordMode(CoordMode mode) { m_coordMode = mode; }
+
+    /**
+     * Get the rubber-band selection mode.
+     */
+    SelectionMode getSelectionMode() { return m_selectionMode; }
+
+    /**
+     * Set the rubber-band selection mode.
+     *
+     * @param mode The selection mode.
+     */
+    void setSelectionMode(SelectionMode mode) { m_selectionMode = mode; }
+
+    /**
+     * Determine whether mouse moves are coalesced.
+     */
+    bool isMouseMoveCoalesced() { return m_mouseMoveCoalesced; }
+
+    /**
+     * Set whether mouse moves are coalesced.
+     * <p>
+     * When coalesced, a move after a pause is processed at once, and the
+     * moves that follow it are paced to the display frame: only the latest
+     * position is processed, once every <code>MOUSE_MOVE_INTERVAL</code>
+     * milliseconds. Otherwise every move is processed as it arrives. Moves
+     * are coalesced by default.
+     * </p>
+     *
+     * @param coalesced <b>true</b> to coalesce mouse moves.
+     */
+    void setMouseMoveCoalesced(bool coalesced);
 
     /**
      * Set the world coordinate space of a bounding region.
@@ -98,8 +243,61 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     bool setWorldCoords(int xmin,int ymin,int xmax,int ymax);
 
+    /**
+     * Set the world coordinate space of a bounding region in double
+     * precision. In <code>COORD_INT</code> mode the bounding region is
+     * limited exactly as for the integer version.
+     *
+     * @param xmin The minimum x component of the bounding region.
+     * @param ymin The minimum y component of the bounding region.
+     * @param xmax The maximum x component of the bounding region.
+     * @param ymax The maximum y component of the bounding region.
+     *
+     * @return <b>true</b> is returned if the world coordinate
+     * extent is successfully set to the bounding region. Otherwise,
+     * <b>false</b> is returned.
+     */
+    bool setWorldCoords(double xmin, double ymin, double xmax, double ymax);
+
+    /**
+     * Pan the world coordinate extent so that the content moves by the
+     * specified device distance.
+     * <p>
+     * The extent is shifted by a whole number of world units and the scale
+     * is left untouched. When that shift is also a whole number of pixels,
+     * the backing store is scrolled and only the newly exposed strips are
+     * rendered; otherwise the whole view is regenerated.
+     * </p>
+     *
+     * @param dx The horizontal distance to move the content, in pixels.
+     * @param dy The vertical distance to move the content, in pixels.
+     *
+     * @return <b>true</b> is returned if the extent is successfully panned.
+     * Otherwise, <b>false</b> is returned.
+     */
+    bool pan(int dx, int dy);
+
+    /**
+     * Get a snapshot of the current world to device mapping.
+     * <p>
+     * This method is lock-free and may be called from any thread. The
+     * snapshot is updated, by the GUI thread only, whenever the extent is
+     * set or panned.
+     * </p>
+     *
+     * @return A consistent copy of the mapping is returned.
+     */
+    VpTransform getTransform() const;
+
     /**
      * Convert the specified world coordinate to device coordinate.
+     * <p>
+     * The coordinate is mapped in double precision by
+     * <code>getWorldToDevMatrix()</code>, the matrix the view is painted
+     * with, and rounded to the nearest integer. Earlier versions mapped in
+     * single precision, so a result near a half pixel may differ from
+     * theirs by one.
+     * </p>
      *
      * @param x The x component of the world coordinate.
      * @param y The y component of the world coordinate.
@@ -108,12 +306,126 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
 
     /**
      * Convert the specified device coordinate to world coordinate.
+     * <p>
+     * The coordinate is mapped in double precision by
+     * <code>getDevToWorldMatrix()</code>, the matrix picking uses, and
+     * rounded to the nearest integer. Earlier versions divided by a single
+     * precision scale instead; where the exact world coordinate lies within
+     * single precision error of a half unit, the result, and any
+     * coordinate snapped from it, may now differ from theirs by one unit.
+     * </p>
      *
      * @param x The x component of the device coordinate.
      * @param y The y component of the device coordinate.
      */
     void devToWorld(int *x, int *y);
 
+    /**
+     * Convert the specified world coordinate to device coordinate in double
+     * precision, without rounding the result.
+     *
+     * @param x The x component of the world coordinate.
+     * @param y The y component of the world coordinate.
+     */
+    void worldToDev(double *x, double *y);
+
+    /**
+     * Convert the specified device coordinate to world coordinate in double
+     * precision, without rounding the result.
+     *
+     * @param x The x component of the device coordinate.
+     * @param y The y component of the device coordinate.
+     */
+    void devToWorld(double *x, double *y);
+
+    /**
+     * Convert an array of world coordinates to device coordinates.
+     * <p>
+     * The scale and offset are fetched once for the whole array. The results
+     * are identical to calling <code>worldToDev(int *, int *)</code> on each
+     * point. <b>src</b> and <b>dst</b> may refer to the same array.
+     * </p>
+     *
+     * @param src The world coordinates to convert.
+     * @param dst Receives the device coordinates.
+     * @param count The number of points to convert.
+     */
+    void worldToDev(const QPoint *src, QPoint *dst, int count);
+
+    /**
+     * Convert an array of world coordinates to device coordinates without
+     * rounding the result. <b>src</b> and <b>dst</b> may refer to the same array.
+     *
+     * @param src The world coordinates to convert.
+     * @param dst Receives the device coordinates.
+     * @param count The number of points to convert.
+     */
+    void worldToDev(const QPointF *src, QPointF *dst, int count);
+
+    /**
+     * Convert an array of device coordinates to world coordinates.
+     * <p>
+     * The scale and offset are fetched once for the whole array. The results
+     * are identical to calling <code>devToWorld(int *, int *)</code> on each
+     * point. <b>src</b> and <b>dst</b> may refer to the same array.
+     * </p>
+     *
+     * @param src The device coordinates to convert.
+     * @param dst Receives the world coordinates.
+     * @param count The number of points to convert.
+     */
+    void devToWorld(const QPoint *src, QPoint *dst, int count);
+
+    /**
+     * Convert an array of device coordinates to world coordinates without
+     * rounding the result. <b>src</b> and <b>dst</b> may refer to the same array.
+     *
+     * @param src The device coordinates to convert.
+     * @param dst Receives the world coordinates.
+     * @param count The number of points to convert.
+     */
+    void devToWorld(const QPointF *src, QPointF *dst, int count);
+
+    /**
+     * Convert a world coordinate to device coordinate. The result is
+     * identical to <code>worldToDev(int *, int *)</code>.
+     *
+     * @param point The world coordinate.
+     *
+     * @return The device coordinate is returned.
+     */
+    VpPoint worldToDev(const VpPoint &point);
+
+    /**
+     * Convert a device coordinate to world coordinate. The result is
+     * identical to <code>devToWorld(int *, int *)</code>.
+     *
+     * @param point The device coordinate.
+     *
+     * @return The world coordinate is returned.
+     */
+    VpPoint devToWorld(const VpPoint &point);
+
+    /**
+     * Convert an array of world coordinates to device coordinates, as
+     * <code>worldToDev(const QPoint *, QPoint *, int)</code> does.
+     *
+     * @param src The world coordinates to convert.
+     * @param dst Receives the device coordinates.
+     * @param count The number of points to convert.
+     */
+    void worldToDev(const VpPoint *src, VpPoint *dst, int count);
+
+    /**
+     * Convert an array of device coordinates to world coordinates, as
+     * <code>devToWorld(const QPoint *, QPoint *, int)</code> does.
+     *
+     * @param src The device coordinates to convert.
+     * @param dst Receives the world coordinates.
+     * @param count The number of points to convert.
+     */
+    void devToWorld(const VpPoint *src, VpPoint *dst, int count);
+
     /**
      * Convert a rectangle from world coordinate space to device coordinate
      * space. Retain the order of min and max.
@@ -123,9 +435,9 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      * @param xmax The maximum x coordinate of the rectangle.
      * @param ymax The maximum y coordinate of the rectangle.
      *
-     * @return A <code>QRect</code> is returned.
+     * @return The device rectangle is returned by value.
      */
-    QRect *worldToDevRect(int xmin,int ymin,int xmax,int ymax);
+    QRect worldToDevRect(int xmin,int ymin,int xmax,int ymax);
 
     /**
      * Scale world coordinates to device coordinates.
@@ -159,8 +471,41 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     static bool intersectWorld(VpGraphics2D &vp, int xll, int yll, int xur, int yur);
 
+    /**
+     * Determine whether a world coordinate rectangle intersects the world
+     * extent of a viewport.
+     *
+     * @param vp A 2D Graphics Viewport.
+     * @param rect The world coordinate rectangle.
+     */
+    static bool intersectWorld(VpGraphics2D &vp, const VpRect &rect)
+    { return vp.getWorldRect().intersects(rect); }
+
+    /**
+     * Get the world coordinate extent as a rectangle.
+     */
+    VpRect getWorldRect() { return VpRect(m_2dWxmin, m_2dWymin, m_2dWxmax, m_2dWymax); }
+
+    /**
+     * Find the display list item nearest a device position, such as that
+     * of a mouse event. The search uses the display list's spatial index,
+     * so it is cheap enough to run on every mouse move.
+     *
+     * @param pos The device position.
+     * @param tolerance The largest distance to an item, in pixels.
+     *
+     * @return The handle of the nearest item is returned, or 0 if no item
+     * is within the tolerance.
+     */
+    VpDisplayList::Handle hitTest(const QPoint &pos, int tolerance = DEFAULT_HIT_TOLERANCE);
+
     /**
      * Draw the grid using the specified graphics context.
+     * <p>
+     * If the grid is adaptive and too fine for the current resolution, it
+     * is drawn at the finest level of detail that can be resolved instead,
+     * with faded minor lines and full strength major lines.
+     * </p>
      *
      * @param gc The Viewport graphics context.
      *
@@ -169,6 +514,137 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     bool drawGrid(VpGC *gc);
 
+    /**
+     * Determine the spacing the grid is displayed with at the current zoom.
+     * <p>
+     * A non-adaptive grid is displayed at its own spacing. An adaptive grid
+     * drops subdivisions, each a factor of <code>getGridLevelBase()</code>,
+     * until its primitives are at least the grid resolution apart.
+     * </p>
+     *
+     * @param dx Receives the x spacing, in world coordinates.
+     * @param dy Receives the y spacing, in world coordinates.
+     * @param opacity Receives the opacity of the level, which fades in from
+     * <code>MIN_GRID_OPACITY</code> as the level opens up.
+     *
+     * @return If the grid can be displayed, then <b>true</b> will be
+     * returned. Otherwise, <b>false</b> will be returned.
+     */
+    bool getGridLevel(int *dx, int *dy, double *opacity);
+
+    /**
+     * Get the factor between successive levels of detail of an adaptive
+     * grid; the multiplier if it is larger than one, otherwise two.
+     */
+    int getGridLevelBase();
+
+    /**
+     * Determine the spacing a grid is displayed with at a pixel size, as
+     * <code>getGridLevel()</code> does for the viewport's grid. It only
+     * reads its arguments, so it may be called from any thread.
+     *
+     * @param grid The grid.
+     * @param pw The width of a pixel, in world coordinates.
+     * @param ph The height of a pixel, in world coordinates.
+     * @param dx Receives the x spacing, in world coordinates.
+     * @param dy Receives the y spacing, in world coordinates.
+     * @param opacity Receives the opacity of the level.
+     *
+     * @return If the grid can be displayed, then <b>true</b> will be
+     * returned. Otherwise, <b>false</b> will be returned.
+     */
+    static bool getGridLevel(VpGrid &grid, double pw, double ph, int *dx, int *dy, double *opacity);
+
+    /**
+     * Get the factor between successive levels of detail of an adaptive
+     * grid.
+     *
+     * @param grid The grid.
+     */
+    static int getGridLevelBase(VpGrid &grid);
+
+    /**
+     * Determine the levels of detail a grid is drawn with at a pixel size,
+     * finest first: the level <code>getGridLevel()</code> finds, and if it
+     * is faded, the major level at full strength above it. It only reads
+     * its arguments, so it may be called from any thread.
+     *
+     * @param grid The grid.
+     * @param pw The width of a pixel, in world coordinates.
+     * @param ph The height of a pixel, in world coordinates.
+     * @param levels Receives the levels; room for two is needed.
+     *
+     * @return The number of levels is returned, or 0 if the grid can not
+     * be displayed.
+     */
+    static int getGridLevels(VpGrid &grid, double pw, double ph, GridLevel *levels);
+
+    /**
+     * Round a double precision coordinate to the nearest <code>int</code>,
+     * saturating at the integer world coordinate extent.
+     *
+     * @param value The coordinate to round.
+     */
+    static int saturate(double value);
+
+    /**
+     * Get the world extent a grid level covers for a device rectangle.
+     *
+     * @param transform The world to device mapping.
+     * @param mode The coordinate mode the mapping is used in.
+     * @param clip The device rectangle, or a null rectangle for the whole
+     * world extent of the mapping.
+     * @param wxmin Receives the minimum x component of the world extent.
+     * @param wymin Receives the minimum y component of the world extent.
+     * @param wxmax Receives the maximum x component of the world extent.
+     * @param wymax Receives the maximum y component of the world extent.
+     */
+    static void getGridExtent(const VpTransform &transform, CoordMode mode, const QRect &clip,
+                              int *wxmin, int *wymin, int *wxmax, int *wymax);
+
+    /**
+     * Draw one level of a grid from its layout. It only reads its
+     * arguments, so it may be called from any thread with a painter of
+     * that thread.
+     *
+     * @param grid The grid.
+     * @param gc The graphics context.
+     * @param transform The world to device mapping.
+     * @param mode The coordinate mode the mapping is used in.
+     * @param layout The layout of the level over the world extent.
+     * @param wxmin The minimum x component of the world extent.
+     * @param wymin The minimum y component of the world extent.
+     * @param wxmax The maximum x component of the world extent.
+     * @param wymax The maximum y component of the world extent.
+     * @param dx The x spacing of the level, in world coordinates.
+     * @param dy The y spacing of the level, in world coordinates.
+     * @param opacity The opacity to draw the level with.
+     */
+    static void drawGridLayout(VpGrid &grid, VpGC *gc, const VpTransform &transform,
+                               CoordMode mode, const VpGridLayout &layout,
+                               int wxmin, int wymin, int wxmax, int wymax,
+                               int dx, int dy, double opacity);
+
+    /**
+     * Draw a grid over the whole world extent of a mapping snapshot, as
+     * <code>drawGrid(VpGC *)</code> does for the viewport's grid. It only
+     * reads its arguments, so it may be called from any thread with a
+     * painter of that thread.
+     *
+     * @param grid The grid.
+     * @param gc The graphics context.
+     * @param transform The world to device mapping.
+     * @param mode The coordinate mode the mapping is used in.
+     * @param pw The width of a pixel, in world coordinates.
+     * @param ph The height of a pixel, in world coordinates.
+     * @param layout Receives the layout of each level drawn.
+     *
+     * @return If the grid is successfully drawn, then <b>true</b> will
+     * be returned. Otherwise, <b>false</b> will be returned.
+     */
+    static bool drawGrid(VpGrid &grid, VpGC *gc, const VpTransform &transform, CoordMode mode,
+                         double pw, double ph, VpGridLayout *layout);
+
     /**
      * Draw the grid reference.
      *
@@ -179,6 +655,82 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     bool drawGridReference(VpGC *gc);
 
+    /**
+     * Draw the grid by compositing cached tiles, rendering the tiles that
+     * are not cached yet.
+     * <p>
+     * Only the tiles covering the clip rectangle of the graphics context
+     * (or the whole viewport) are drawn. A tile is rendered against the
+     * deadline of the graphics context, and the tiles after the first
+     * rendered are only started while the frame's budget lasts; drawing
+     * then stops with the deadline stopped, and an interrupted tile is
+     * not cached.
+     * </p>
+     *
+     * @param gc The Viewport graphics context.
+     *
+     * @return If the grid is successfully drawn, then <b>true</b> will
+     * be returned. Otherwise, <b>false</b> will be returned.
+     */
+    bool drawGridTiles(VpGC *gc);
+
+    /**
+     * Enable or disable the grid tile cache.
+     *
+     * @param budget The memory budget of the cache, in kilobytes. A budget
+     * of <b>0</b> disables tiling and the grid is drawn directly.
+     */
+    void setGridTileCacheBudget(int budget);
+
+    /**
+     * Get the time budget for drawing the grid, in milliseconds.
+     */
+    int getGridTimeBudget() { return m_gridTimeBudget; }
+
+    /**
+     * Set the time budget for drawing the grid in one frame.
+     * <p>
+     * With a budget, a full repaint first shows a coarse grid and then
+     * refines it in horizontal strips, resuming in the following frames
+     * once the budget is spent. <code>gridComplete()</code> is emitted when
+     * the last strip has been drawn.
+     * </p>
+     *
+     * @param budget The budget, in milliseconds. A budget of <b>0</b> draws
+     * the whole grid in a single frame.
+     */
+    void setGridTimeBudget(int budget);
+
+    /**
+     * Get the rendering mode.
+     */
+    RenderMode getRenderMode() { return m_renderMode; }
+
+    /**
+     * Set the rendering mode.
+     * <p>
+     * In <code>RENDER_THREADED</code> mode the grid and the display list
+     * are rasterized into an image on a worker thread, from snapshots of
+     * the mapping, the grid and the display list, and painting only
+     * presents the latest completed frame. A heavy frame then no longer
+     * holds up input handling. Until a frame for the current mapping
+     * completes, the previous frame is shown mapped to it, and frames made
+     * stale by a newer request are dropped. The grid tile cache and the
+     * grid time budget only apply to <code>RENDER_DIRECT</code> mode.
+     * </p>
+     *
+     * @param mode The rendering mode.
+     */
+    void setRenderMode(RenderMode mode);
+
+    /**
+     * Determine whether the grid is completely drawn.
+     *
+     * @return <b>true</b> is returned if no grid strips are left to be drawn
+     * in a later frame. Otherwise, <b>false</b> will be returned.
+     */
+    bool isGridComplete() { return m_backingStoreDirty.isEmpty(); }
+
     /**
      * Display the grid based on the context of its state.
      *
@@ -230,6 +782,35 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     void snapToGrid(int *x, int *y);
 
+    /**
+     * Snap an array of coordinates to the nearest grid coordinates.
+     * <b>src</b> and <b>dst</b> may refer to the same array.
+     *
+     * @param src The coordinates to snap.
+     * @param dst Receives the snapped coordinates.
+     * @param count The number of points to snap.
+     */
+    void snapToGrid(const QPoint *src, QPoint *dst, int count);
+
+    /**
+     * Snap the specified double precision coordinate to the nearest grid
+     * coordinate.
+     *
+     * @param x The x component of the coordinate to snap.
+     * @param y The y component of the coordinate to snap.
+     */
+    void snapToGrid(double *x, double *y);
+
+    /**
+     * Snap a coordinate to the nearest grid coordinate. The result is
+     * identical to <code>snapToGrid(int *, int *)</code>.
+     *
+     * @param point The coordinate to snap.
+     *
+     * @return The snapped coordinate is returned.
+     */
+    VpPoint snapToGrid(const VpPoint &point);
+
     /**
      * Retrieve the state of the grid as a string.
      */
@@ -238,12 +819,25 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
   signals:
 
     /**
-     * Emit a mouse moved signal.
+     * Emit a mouse moved signal. Fast moves are coalesced, so the signal
+     * carries the latest move at most once per frame. The event is only
+     * built if the signal is connected; <code>mouseMovedTo()</code> carries
+     * the same move without one.
      *
      * @param event The event to signal.
      */
     void mouseMoved(const QMouseEvent &event);
 
+    /**
+     * Emit a mouse moved signal carrying the position of the latest move,
+     * at most once per frame.
+     *
+     * @param pos The position of the mouse, in device coordinates.
+     * @param buttons The mouse buttons held down.
+     * @param modifiers The keyboard modifiers held down.
+     */
+    void mouseMovedTo(const QPointF &pos, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers);
+
     /**
      * Emit a mouse pressed signal.
      *
@@ -267,12 +861,47 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
     void newExtent(const QRect &size, const QPoint &origin);
 
     /**
-     * @brief Signal that world coordinate has changed.
+     * @brief Signal that world coordinate has changed. It is only emitted
+     * when the (snapped) coordinate under the mouse actually changes.
      *
      * @param coord The world coordinate.
      */
     void coordChanged(const VpCoord &coord);
 
+    /**
+     * @brief Signal that world coordinate has changed, without the
+     * viewport name. It is emitted with <code>coordChanged()</code> but
+     * carries a plain value, so emitting it never touches the heap.
+     *
+     * @param point The world coordinate.
+     */
+    void pointChanged(const VpPoint &point);
+
+    /**
+     * @brief Signal that a new world to device mapping has been published,
+     * after the extent is set, panned or resized.
+     *
+     * @param transform A snapshot of the new mapping.
+     */
+    void transformChanged(const VpTransform &transform);
+
+    /**
+     * @brief Signal that the grid has been completely drawn.
+     */
+    void gridComplete();
+
+    /**
+     * @brief Signal that a rubber-band selection has been made.
+     * <p>
+     * A click that does not drag out a band is only signalled if it changes
+     * the selection, such as by clearing it.
+     * </p>
+     *
+     * @param items The handles of the display list items selected. The
+     * list is empty if nothing was selected.
+     */
+    void itemsSelected(const QVector<VpDisplayList::Handle> &items);
+
     /**
      * @brief Signal that the status msg has changed.
      *
@@ -280,13 +909,50 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     void updateStatus(const QString &msg);
 
+  public slots:
+
+    /**
+     * @brief Discard the cached rendering of the viewport and schedule a repaint.
+     * <p>
+     * The viewport keeps its grid rendered in a backing store that is only
+     * regenerated when the world extent, the grid state, the display list or the
+     * widget size changes. Call this after modifying the grid directly through
+     * <code>getGrid()</code>.
+     * </p>
+     */
+    void invalidate();
+
+    /**
+     * @brief Abandon the grid strips that are still waiting to be drawn.
+     * <p>
+     * The partially refined grid stays on screen until the view is next
+     * invalidated. A strip being drawn stops at its next row.
+     * </p>
+     */
+    void cancelGrid();
+
   protected slots:
 
     /**
-     * Process the coordinate.
+     * Process the coordinate of a mouse event, emitting
+     * <code>coordChanged()</code> if it differs from the last one.
+     *
+     * @deprecated Mouse moves are processed by the viewport itself, which
+     * emits <code>coordChanged()</code>; this slot is no longer connected
+     * and is kept only for compatibility.
      */
     void processCoord(const QMouseEvent &event);
 
+    /**
+     * Schedule a repaint of the grid strips left over from the last frame.
+     */
+    void continueGrid();
+
+    /**
+     * Take the frame the render thread has completed and repaint with it.
+     */
+    void presentFrame();
+
   protected:
 
     static bool adjustExtentToViewport(VpGraphics2D &vp,
@@ -317,8 +983,149 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
      */
     void mouseReleaseEvent(QMouseEvent *event);
 
+    /**
+     * The handler for timer events; paces the processing of mouse moves.
+     *
+     * @param event The timer event.
+     */
+    void timerEvent(QTimerEvent *event);
+
     bool eventFilter(QObject *obj, QEvent *ev);
 
+    /**
+     * Regenerate the backing store from the current world extent and grid.
+     *
+     * @param region The device region to regenerate. An empty region
+     * regenerates the whole backing store.
+     */
+    void renderBackingStore(const QRegion &region = QRegion());
+
+    /**
+     * Scroll the backing store and the widget by a device distance, marking
+     * the newly exposed strips for rendering.
+     *
+     * @param dx The horizontal distance, in pixels.
+     * @param dy The vertical distance, in pixels.
+     */
+    void scrollBackingStore(int dx, int dy);
+
+    /**
+     * Copy a device rectangle from the backing store to the widget.
+     *
+     * @param gc The painter drawing the widget.
+     * @param r The device rectangle, in device independent pixels.
+     * @param ratio The device pixel ratio of the backing store.
+     */
+    void copyBackingStore(QPainter *gc, const QRect &r, qreal ratio);
+
+    /**
+     * Paint the view from the latest frame of the render thread, requesting
+     * a new frame if the view has changed.
+     *
+     * @param event The paint event.
+     */
+    void paintFrame(QPaintEvent *event);
+
+    /**
+     * Request a frame of the current view from the render thread.
+     */
+    void requestFrame();
+
+    /**
+     * Copy a device rectangle from the latest frame of the render thread.
+     *
+     * @param gc The painter drawing the widget.
+     * @param r The device rectangle to copy.
+     * @param ratio The device pixel ratio of the frame.
+     */
+    void copyFrame(QPainter *gc, const QRect &r, qreal ratio);
+
+    /**
+     * Draw the display list over a device area of the backing store.
+     *
+     * @param gc The painter drawing the backing store.
+     * @param area The device area to draw.
+     */
+    void drawDisplayList(QPainter *gc, const QRect &area);
+
+    /**
+     * Convert a device position to world coordinates, snapping it to the
+     * grid if the grid is on.
+     *
+     * @param pos The device position.
+     */
+    QPointF devToSnappedWorld(const QPoint &pos);
+
+    /**
+     * Emit <code>coordChanged()</code> for a world coordinate, unless it is
+     * the coordinate last emitted.
+     *
+     * @param x The x component of the world coordinate.
+     * @param y The y component of the world coordinate.
+     */
+    void updateCoord(int x, int y);
+
+    /**
+     * Process the latest coalesced mouse move, if any.
+     */
+    void processMouseMove();
+
+    /**
+     * Publish the current extent, scale and offset as a new transform
+     * snapshot for <code>getTransform()</code>, and signal it with
+     * <code>transformChanged()</code>. This must only be called from the GUI
+     * thread; the snapshot's sequence lock has a single writer.
+     */
+    void publishTransform();
+
+    /**
+     * Draw one level of the grid.
+     *
+     * @param gc The Viewport graphics context.
+     * @param dx The x spacing of the level, in world coordinates.
+     * @param dy The y spacing of the level, in world coordinates.
+     * @param opacity The opacity to draw the level with.
+     *
+     * @return If the level is successfully drawn, then <b>true</b> will
+     * be returned. Otherwise, <b>false</b> will be returned.
+     */
+    bool drawGridLevel(VpGC *gc, int dx, int dy, double opacity);
+
+    /**
+     * Get the layout of the grid at the specified spacing over a world
+     * extent. The most recent layouts are cached, so the layout is only
+     * recomputed when the extent or the grid parameters change.
+     *
+     * @param wxmin The minimum x component of the world extent.
+     * @param wymin The minimum y component of the world extent.
+     * @param wxmax The maximum x component of the world extent.
+     * @param wymax The maximum y component of the world extent.
+     * @param dx The x spacing of the primitives, in world coordinates.
+     * @param dy The y spacing of the primitives, in world coordinates.
+     */
+    const VpGridLayout &getGridLayout(int wxmin, int wymin, int wxmax, int wymax,
+                                      int dx, int dy);
+
+    /**
+     * Get the world to device transform used to render the viewport; the
+     * same matrix as <code>getWorldToDevMatrix()</code>.
+     */
+    QTransform getRenderTransform();
+
+    /**
+     * Draw a coarse preview of the grid, shown at once while the full grid
+     * is refined in strips.
+     * <p>
+     * The preview is the grid's full strength level, spaced
+     * <code>COARSE_GRID_FACTOR</code> times wider, so every primitive it
+     * draws is also drawn by the full grid. It bypasses the tile cache and
+     * omits the reference marker, and leaves the grid itself untouched.
+     * </p>
+     *
+     * @param gc The graphics context.
+     */
+    void drawCoarseGrid(VpGC *gc);
+
   protected:
 
     int   m_2dWxmin;
@@ -331,10 +1138,44 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
     float m_2dYOffset;
     float m_2dPixelWidth;
     float m_2dPixelHeight;
+    double m_2dWxminF;
+    double m_2dWyminF;
+    double m_2dWxmaxF;
+    double m_2dWymaxF;
+    double m_2dXScaleF;
+    double m_2dYScaleF;
+    double m_2dXOffsetF;
+    double m_2dYOffsetF;
+    float m_2dXInvScale;
+    float m_2dYInvScale;
+    QTransform m_worldToDevMatrix;
+    QTransform m_devToWorldMatrix;
     VpGrid *m_2dGrid;
 
+    // The world coordinate mode.
+    CoordMode m_coordMode;
+
+    // The cache of rendered grid tiles; NULL if tiling is disabled.
+    VpGridTileCache *m_gridTileCache;
+
+    // The retained world coordinate primitives.
+    VpDisplayList *m_displayList;
+
     static const int MAX_WC_EXTENT;
     static const int MIN_WC_EXTENT;
+    // The largest world coordinate magnitude in COORD_DOUBLE mode.
+    static const double MAX_WC_EXTENT_F;
+
+    // The default time budget for drawing the grid, in milliseconds.
+    static const int DEFAULT_GRID_TIME_BUDGET = 8;
+    // The height of the strips the grid is refined in, in pixels.
+    static const int GRID_STRIP_HEIGHT = 32;
+    // The multiplier applied to the grid spacing for the coarse pass.
+    static const int COARSE_GRID_FACTOR = 4;
+    // The opacity of an adaptive grid level as it first becomes visible.
+    static const double MIN_GRID_OPACITY;
+    // The number of grid layouts kept for reuse.
+    static const int GRID_LAYOUT_CACHE_SIZE = 2;
 
     // The rubber-band.
     QRubberBand *m_rubberBand;
@@ -342,9 +1183,66 @@ class QTVPSHARED_EXPORT VpGraphics2D : public VpViewport
     QPoint m_rubberBandOrigin;
     // Flag indicating if currently rubber-banding.
     bool m_rubberBandIsShown;
+    // The origin of the rubber-band, in world coordinates.
+    QPointF m_rubberBandOriginF;
+    // The rubber-band selection mode.
+    SelectionMode m_selectionMode;
+    // The items of the current and the previous selection.
+    QVector<VpDisplayList::Handle> m_selection;
+    QVector<VpDisplayList::Handle> m_lastSelection;
+
+    // The latest mouse move, waiting to be processed.
+    bool    m_mousePending;
+    QPointF m_mousePos;
+    QPointF m_mouseWindowPos;
+    QPointF m_mouseScreenPos;
+    Qt::MouseButtons m_mouseButtons;
+    Qt::KeyboardModifiers m_mouseModifiers;
+    // Paces the processing of mouse moves to the display frame. The timer
+    // runs while moves keep arriving and stops once a frame passes
+    // without one.
+    bool m_mouseMoveCoalesced;
+    QBasicTimer m_mouseTimer;
+
+    // The world coordinate last emitted by coordChanged().
+    bool m_coordValid;
+    int  m_coordX;
+    int  m_coordY;
 
     QPainter *m_painter;
 
+    // The retained rendering of the viewport.
+    QPixmap m_backingStore;
+    // Flag indicating if the backing store is up to date.
+    bool m_backingStoreValid;
+    // Parts of a valid backing store that still need to be rendered.
+    QRegion m_backingStoreDirty;
+    // The time budget for drawing the grid in one frame, in milliseconds.
+    int m_gridTimeBudget;
+    // Flag indicating if a repaint is scheduled to continue the grid.
+    bool m_gridPending;
+    // Stops the grid strips of a frame once its time budget is spent.
+    VpDeadline m_gridDeadline;
+    // The rendering mode and, when threaded, the worker.
+    RenderMode m_renderMode;
+    VpRenderThread *m_renderThread;
+    // The latest frame of the render thread and the mapping it shows.
+    QImage m_frame;
+    VpTransform m_frameTransform;
+    // The size, in device pixels, of the last frame requested.
+    QSize m_frameRequestSize;
+    // The most recently used grid layouts.
+    VpGridLayout m_gridLayouts[GRID_LAYOUT_CACHE_SIZE];
+    // The next grid layout to be replaced.
+    int m_gridLayoutNext;
+
+    // The published transform and its sequence counter. The counter is odd
+    // while the snapshot is being written, so readers can retry. Only the
+    // GUI thread writes it, in publishTransform().
+    VpTransform m_transform;
+    QAtomicInt m_transformSequence;
+    unsigned int m_transformVersion;
+
 };
 
 #endif // __VPGRAPHICS2D_H_
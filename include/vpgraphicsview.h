@@ -26,10 +26,14 @@
 
 // Include Qt header files.
 #include <QScrollArea>
+#include <QTimer>
+#include <QPointer>
 
 // Include QtVp header files.
 #include "qtvp_global.h"
+#include "vpgraphics2d.h"
 #include "vpruler.h"
+#include "vptransform.h"
 
 class QTVPSHARED_EXPORT VpGraphicsView : public QScrollArea
 {
@@ -42,15 +46,81 @@ class QTVPSHARED_EXPORT VpGraphicsView : public QScrollArea
 
     void init(QWidget *widget);
 
+    /**
+     * Filter the events of the view's window, to propagate extent changes
+     * just before the window is repainted.
+     *
+     * @param obj The object the event is for.
+     * @param ev The event.
+     */
+    bool eventFilter(QObject *obj, QEvent *ev);
+
+    /**
+     * Handle the view's events, following the view to a new window when
+     * it is reparented.
+     *
+     * @param ev The event.
+     */
+    bool event(QEvent *ev);
+
   signals:
     
   public slots:
 
     void on_newExtent(QRect size, QPoint origin);
+    void on_newExtent(QRectF size, QPointF origin);
     void on_trackExtent(bool track);
+
+    /**
+     * Hand the content viewport's new mapping to both rulers.
+     *
+     * @param transform A snapshot of the content viewport's mapping.
+     */
+    void on_newTransform(const VpTransform &transform);
+
+  protected slots:
+
+    /**
+     * Hand the latest pending extent or mapping to both rulers.
+     */
+    void propagate();
+
+  protected:
+
+    /**
+     * Schedule the propagation of pending changes, at most once per frame.
+     */
+    void schedulePropagation();
+
+    /**
+     * Filter the events of the view's current window, and stop filtering
+     * those of the window it was in before.
+     */
+    void watchWindow();
     
   private:
 
+    // The longest a pending change waits for the window to repaint, in
+    // milliseconds.
+    static const int FRAME_INTERVAL = 16;
+
+    // The latest changes, waiting to be propagated to the rulers.
+    bool m_transformPending;
+    VpTransform m_pendingTransform;
+    bool m_extentPending;
+    bool m_extentIsF;
+    QRect m_pendingExtent;
+    QPoint m_pendingOrigin;
+    QRectF m_pendingExtentF;
+    QPointF m_pendingOriginF;
+    // Propagates the changes if the window does not repaint in time.
+    QTimer m_propagateTimer;
+    // The window whose events are filtered.
+    QPointer<QWidget> m_window;
+
+    /** The content viewport, if the view's widget is one. */
+    VpGraphics2D *m_content;
+
     /** Horizontal ruler. */
     VpRuler *m_horizontalRuler;
     /** Vertical ruler. */
@@ -26,6 +26,12 @@
 
 // Include Qt header files.
 #include <QObject>
+#include <QVector>
+#include <QLine>
+#include <QPoint>
+#include <QImage>
+#include <QPen>
+#include <QBrush>
 
 // Include QtVp header files.
 #include "qtvp_global.h"
@@ -58,6 +64,7 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
     Q_PROPERTY(int yAlignment READ getYAlignment WRITE setYAlignment)
     Q_PROPERTY(int xResolution READ getXResolution WRITE setXResolution)
     Q_PROPERTY(int yResolution READ getYResolution WRITE setYResolution)
+    Q_PROPERTY(bool adaptive READ isAdaptive WRITE setAdaptive)
     Q_PROPERTY(RefState referenceState READ getReferenceState WRITE setReferenceState)
     Q_PROPERTY(RefStyle referenceStyle READ getReferenceStyle WRITE setReferenceStyle)
     Q_PROPERTY(VpColor referenceColor READ getReferenceColor WRITE setReferenceColor)
@@ -97,12 +104,24 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
     void setXResolution(int value) { m_xResolution = value; }
     int  getYResolution() { return m_yResolution; }
     void setYResolution(int value) { m_yResolution = value; }
+    bool isAdaptive() { return m_adaptive; }
+    void setAdaptive(bool value) { m_adaptive = value; }
     RefState getReferenceState() { return m_referenceState; }
     void setReferenceState(RefState value) { m_referenceState = value; }
     RefStyle getReferenceStyle() { return m_referenceStyle; }
     void setReferenceStyle(RefStyle value) { m_referenceStyle = value; }
     VpColor &getReferenceColor() { return m_referenceColor; }
     void setReferenceColor(const VpColor &value) { m_referenceColor = value; }
+    bool isRasterStamping() { return m_rasterStamping; }
+    void setRasterStamping(bool value) { m_rasterStamping = value; }
+
+    /**
+     * Copy the characteristics of another grid, such as to render a
+     * snapshot of it from another thread.
+     *
+     * @param grid The grid to copy.
+     */
+    void copy(VpGrid &grid);
 
     /**
      * Snap the specified coordinate to a grid location.
@@ -116,6 +135,37 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
      */
     bool snapToGrid(int *x, int *y);
 
+    /**
+     * Snap an array of coordinates to grid locations.
+     * <p>
+     * The results are identical to calling <code>snapToGrid(int *, int *)</code>
+     * on each point. <b>src</b> and <b>dst</b> may refer to the same array.
+     * </p>
+     *
+     * @param src The coordinates to snap.
+     * @param dst Receives the snapped coordinates.
+     * @param count The number of points to snap.
+     *
+     * @return <b>true</b> will be returned if the specified
+     * coordinates are successfully snapped to the nearest grid points.
+     * Otherwise <b>false</b> will be returned.
+     */
+    bool snapToGrid(const QPoint *src, QPoint *dst, int count);
+
+    /**
+     * Snap the specified double precision coordinate to a grid location.
+     * The result is identical to <code>snapToGrid(int *, int *)</code>
+     * wherever that does not overflow.
+     *
+     * @param x The x component of the coordinate to snap.
+     * @param y The y component of the coordinate to snap.
+     *
+     * @return <b>true</b> will be returned if the specified
+     * coordinate is successfully snapped to the nearest grid point.
+     * Otherwise <b>false</b> will be returned.
+     */
+    bool snapToGrid(double *x, double *y);
+
     /**
      * Get a coordinate based on the spacing and multiplier state
      * of the grid.
@@ -139,6 +189,12 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
 
     /**
      * Draw the grid with the specified context.
+     * <p>
+     * If the context has a deadline, it is polled once per row of
+     * primitives. Once it expires, drawing stops and whatever was not yet
+     * submitted is abandoned; the caller learns of it from
+     * <code>VpDeadline::isStopped()</code>.
+     * </p>
      *
      * @param gridGC The grid context.
      */
@@ -194,7 +250,8 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
     /**
      * Draw the grid using dots.
      * <p>
-     * The algorithm used to draw the grid entails drawing each dot individually.
+     * The algorithm used to draw the grid collects all dots in a reusable
+     * buffer and submits them with a single call.
      * </p>
      *
      * @param gridGC The grid context.
@@ -204,13 +261,41 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
     /**
      * Draw the grid using crosses.
      * <p>
-     * The algorithm used to draw the grid entails drawing each cross individually.
+     * The algorithm used to draw the grid collects the two strokes of every
+     * cross in a reusable buffer and submits them with a single call.
      * </p>
      *
      * @param gridGC The grid context.
      */
     void drawCrossGrid(GridGC &gridGC);
 
+    /**
+     * Draw a dot or cross grid by stamping rows.
+     * <p>
+     * A single row of the pattern is rendered into a device image, one
+     * pixel per grid column, and then stamped once for every grid row. This
+     * costs O(columns + rows) instead of O(columns * rows). It is only
+     * possible when the painter maps world to device without rotation.
+     * The image is built at the device pixel ratio of the paint device, so
+     * dots stay one device pixel on HiDPI targets, as the vector path
+     * draws them.
+     * </p>
+     *
+     * @param gridGC The grid context.
+     * @param cross <b>true</b> to stamp crosses, <b>false</b> to stamp dots.
+     *
+     * @return <b>true</b> is returned if the grid was drawn. Otherwise,
+     * <b>false</b> is returned and the caller must draw the grid itself.
+     */
+    bool drawStampedGrid(GridGC &gridGC, bool cross);
+
+    /**
+     * Bring the cached pens and brushes up to date with the grid and
+     * reference colors. They are only rebuilt when a color changes, so
+     * drawing does not allocate pen or brush data every frame.
+     */
+    void updatePens();
+
   private:
 
     State   m_state;
@@ -223,11 +308,30 @@ class QTVPSHARED_EXPORT VpGrid : public QObject
     int     m_yAlignment;
     int     m_xResolution;
     int     m_yResolution;
+    // Flag indicating if the grid coarsens itself when too fine to display.
+    bool    m_adaptive;
 
     RefState m_referenceState;
     RefStyle m_referenceStyle;
     VpColor  m_referenceColor;
 
+    // Reusable primitive buffers. They grow to the largest grid drawn and
+    // are never shrunk, so drawing does not reallocate them every frame.
+    QVector<QLine>  m_lines;
+    QVector<QPoint> m_points;
+
+    // The pens and brushes the grid and its reference are drawn with.
+    QPen   m_gridPen;
+    QBrush m_gridBrush;
+    QPen   m_referencePen;
+    QBrush m_referenceBrush;
+
+    // Flag indicating if dot and cross grids may be drawn by stamping rows.
+    bool    m_rasterStamping;
+    // Reusable buffers for row stamping.
+    QVector<int> m_columns;
+    QImage  m_stamp;
+
 };
 
 struct GridState
@@ -0,0 +1,114 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+#ifndef __VPGRIDLAYOUT_H_
+#define __VPGRIDLAYOUT_H_
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+#include "vpgrid.h"
+
+/**
+ * The <code>VpGridLayout</code> class computes where the primitives of a
+ * grid fall within a world extent.
+ * <p>
+ * The extent is snapped outward (lines and crosses) or inward (dots) to
+ * the grid spacing and the number of primitives along each axis follows in
+ * closed form. The arithmetic is done in 64 bits, and the snapped extent is
+ * trimmed by whole grid steps to the range of an <code>int</code>, so an
+ * extent reaching <code>MAX_WC_EXTENT</code> neither overflows nor costs
+ * more than a few operations.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpGridLayout
+{
+  public:
+
+    /**
+     * @brief Default constructor. Creates a layout that matches no input.
+     */
+    VpGridLayout();
+
+    /**
+     * Compute the layout of a grid over a world extent.
+     *
+     * @param wxmin The minimum x component of the world extent.
+     * @param wymin The minimum y component of the world extent.
+     * @param wxmax The maximum x component of the world extent.
+     * @param wymax The maximum y component of the world extent.
+     * @param dx The x spacing of the primitives, in world coordinates.
+     * @param dy The y spacing of the primitives, in world coordinates.
+     * @param xalignment The x alignment of the grid.
+     * @param yalignment The y alignment of the grid.
+     * @param style The grid style.
+     */
+    void compute(int wxmin, int wymin, int wxmax, int wymax,
+                 int dx, int dy, int xalignment, int yalignment,
+                 VpGrid::Style style);
+
+    /**
+     * Determine whether this layout was computed from the specified input.
+     *
+     * @return <b>true</b> is returned if <code>compute()</code> would
+     * produce the same layout. Otherwise, <b>false</b> is returned.
+     */
+    bool isLayoutOf(int wxmin, int wymin, int wxmax, int wymax,
+                    int dx, int dy, int xalignment, int yalignment,
+                    VpGrid::Style style) const;
+
+    // Accessors for the snapped extent and the primitive counts, in the
+    // form expected by <code>GridGC</code> for the layout's style.
+    int getXll() const { return m_xll; }
+    int getYll() const { return m_yll; }
+    int getXur() const { return m_xur; }
+    int getYur() const { return m_yur; }
+    int getXnum() const { return m_xnum; }
+    int getYnum() const { return m_ynum; }
+
+  private:
+
+    // The input the layout was computed from.
+    bool m_valid;
+    int  m_wxmin;
+    int  m_wymin;
+    int  m_wxmax;
+    int  m_wymax;
+    int  m_dx;
+    int  m_dy;
+    int  m_xalignment;
+    int  m_yalignment;
+    VpGrid::Style m_style;
+
+    // The computed layout.
+    int  m_xll;
+    int  m_yll;
+    int  m_xur;
+    int  m_yur;
+    int  m_xnum;
+    int  m_ynum;
+};
+
+#endif // __VPGRIDLAYOUT_H_
@@ -0,0 +1,163 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+#ifndef __VPGRIDTILECACHE_H_
+#define __VPGRIDTILECACHE_H_
+
+// Include Qt header files.
+#include <QCache>
+#include <QPixmap>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+#include "vpgrid.h"
+
+/**
+ * The <code>VpGridTileKey</code> identifies one rendered grid tile.
+ * <p>
+ * A tile's content depends only on the zoom (scale), the sub-pixel phase
+ * of the world origin on the device, the grid parameters and the tile's
+ * position, so tiles can be reused while panning and when returning to a
+ * previous zoom level.
+ * </p>
+ */
+struct QTVPSHARED_EXPORT VpGridTileKey
+{
+    VpGridTileKey();
+
+    /**
+     * Fill in the grid parameters of the key.
+     *
+     * @param grid The grid the tile is rendered from.
+     */
+    void setGrid(VpGrid &grid);
+
+    bool operator==(const VpGridTileKey &key) const;
+
+    // The world to device mapping.
+    double m_xscale;
+    double m_yscale;
+    double m_xphase;
+    double m_yphase;
+    double m_ratio;
+
+    // The grid parameters.
+    int  m_style;
+    uint m_color;
+    int  m_xSpacing;
+    int  m_ySpacing;
+    int  m_multiplier;
+    int  m_xAlignment;
+    int  m_yAlignment;
+    int  m_xResolution;
+    int  m_yResolution;
+    bool m_adaptive;
+
+    // The tile index.
+    int  m_tx;
+    int  m_ty;
+};
+
+QTVPSHARED_EXPORT uint qHash(const VpGridTileKey &key);
+
+/**
+ * The <code>VpGridTileCache</code> class keeps rendered grid tiles in a
+ * least-recently-used cache bounded by a memory budget.
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpGridTileCache
+{
+  public:
+
+    // The width and height of a tile, in device independent pixels.
+    static const int TILE_SIZE = 256;
+
+    // The steps per device pixel the sub-pixel phase of a tile is
+    // quantised to, so that a fractional pan does not miss every tile.
+    static const int PHASE_STEPS = 256;
+
+    // The default memory budget, in kilobytes.
+    static const int DEFAULT_BUDGET = 32 * 1024;
+
+    /**
+     * A constructor that specifies the memory budget.
+     *
+     * @param budget The memory budget, in kilobytes.
+     */
+    explicit VpGridTileCache(int budget = DEFAULT_BUDGET);
+
+    /**
+     * @brief The destructor.
+     */
+    virtual ~VpGridTileCache();
+
+    /**
+     * Get the memory budget, in kilobytes.
+     */
+    int getBudget() { return m_tiles.maxCost(); }
+
+    /**
+     * Set the memory budget, in kilobytes. Least recently used tiles are
+     * discarded until the cache fits the new budget.
+     *
+     * @param budget The memory budget, in kilobytes.
+     */
+    void setBudget(int budget) { m_tiles.setMaxCost(budget); }
+
+    /**
+     * Get the memory used by the cached tiles, in kilobytes.
+     */
+    int getUsage() { return m_tiles.totalCost(); }
+
+    /**
+     * Find a tile, marking it as most recently used.
+     *
+     * @param key The tile to look for.
+     *
+     * @return The tile is returned, or <b>NULL</b> if it is not cached.
+     * The cache keeps ownership of the tile.
+     */
+    QPixmap *find(const VpGridTileKey &key) { return m_tiles.object(key); }
+
+    /**
+     * Add a tile to the cache.
+     *
+     * @param key The tile identifier.
+     * @param tile The rendered tile. The cache takes ownership of it and may
+     * delete it immediately if it does not fit the budget.
+     */
+    void insert(const VpGridTileKey &key, QPixmap *tile);
+
+    /**
+     * Discard all cached tiles.
+     */
+    void clear() { m_tiles.clear(); }
+
+  private:
+
+    // The cached tiles; the cost of a tile is its size in kilobytes.
+    QCache<VpGridTileKey, QPixmap> m_tiles;
+};
+
+#endif // __VPGRIDTILECACHE_H_
@@ -0,0 +1,127 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+#ifndef __VPKERNELS_H_
+#define __VPKERNELS_H_
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+
+/**
+ * The <code>VpKernels</code> class provides the array kernels behind the
+ * batched coordinate transform and grid snapping routines.
+ * <p>
+ * Each kernel operates on interleaved (x,y) integer pairs and has a scalar,
+ * an SSE2 and an AVX2 implementation. The implementation is selected at
+ * runtime from the capabilities of the CPU. All implementations produce
+ * results identical to the scalar routines in <code>VpGraphics2D</code>
+ * and <code>VpGrid</code>. Source and destination may be the same array.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpKernels
+{
+  public:
+
+    // Instruction set used by the kernels.
+    enum Isa { ISA_SCALAR, ISA_SSE2, ISA_AVX2 };
+
+    /**
+     * Get the instruction set used by the kernels.
+     *
+     * @return The instruction set is returned. Unless overridden with
+     * <code>setIsa()</code>, this is the best one supported by the CPU.
+     */
+    static Isa getIsa();
+
+    /**
+     * Override the instruction set used by the kernels.
+     *
+     * @param isa The instruction set to use. If the CPU does not support it,
+     * the best supported instruction set is used instead.
+     */
+    static void setIsa(Isa isa);
+
+    /**
+     * Get the best instruction set supported by the CPU.
+     */
+    static Isa getSupportedIsa();
+
+    /**
+     * Map world coordinates to device coordinates; dst = round(src * scale + offset).
+     * The arithmetic is carried out in double precision, so passing the
+     * scale and offset of the viewport's world to device matrix reproduces
+     * <code>QTransform::map()</code> before rounding.
+     *
+     * @param src The interleaved (x,y) world coordinates.
+     * @param dst Receives the interleaved (x,y) device coordinates.
+     * @param count The number of (x,y) pairs.
+     * @param xscale The x scale factor.
+     * @param yscale The y scale factor.
+     * @param xoffset The x offset.
+     * @param yoffset The y offset.
+     */
+    static void worldToDev(const int *src, int *dst, int count,
+        double xscale, double yscale, double xoffset, double yoffset);
+
+    /**
+     * Map device coordinates to world coordinates through the inverse
+     * mapping; dst = round(src * invscale + invoffset). The arithmetic is
+     * carried out in double precision, as for <code>worldToDev()</code>.
+     *
+     * @param src The interleaved (x,y) device coordinates.
+     * @param dst Receives the interleaved (x,y) world coordinates.
+     * @param count The number of (x,y) pairs.
+     * @param xinvscale The x scale factor of the inverse mapping.
+     * @param yinvscale The y scale factor of the inverse mapping.
+     * @param xinvoffset The x offset of the inverse mapping.
+     * @param yinvoffset The y offset of the inverse mapping.
+     */
+    static void devToWorld(const int *src, int *dst, int count,
+        double xinvscale, double yinvscale, double xinvoffset, double yinvoffset);
+
+    /**
+     * Snap coordinates to the nearest grid location;
+     * dst = round((src - alignment) / spacing) * spacing + alignment.
+     *
+     * @param src The interleaved (x,y) coordinates to snap.
+     * @param dst Receives the interleaved (x,y) snapped coordinates.
+     * @param count The number of (x,y) pairs.
+     * @param xspacing The x grid spacing.
+     * @param yspacing The y grid spacing.
+     * @param xalignment The x grid alignment.
+     * @param yalignment The y grid alignment.
+     */
+    static void snapToGrid(const int *src, int *dst, int count,
+        int xspacing, int yspacing, int xalignment, int yalignment);
+
+  private:
+
+    VpKernels();
+
+    // The instruction set currently in use.
+    static Isa g_isa;
+};
+
+#endif // __VPKERNELS_H_
@@ -0,0 +1,111 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+#ifndef __VPPOINT_H_
+#define __VPPOINT_H_
+
+// Include Qt header files.
+#include <QMetaType>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+
+/**
+ * The <code>VpPoint</code> is a two dimensional world or device coordinate.
+ * <p>
+ * It is a plain value: trivially copyable, laid out as two <code>int</code>s
+ * exactly like <code>QPoint</code>, and free of any shared data. Copying it,
+ * storing it in a container or passing it through a signal never touches
+ * the heap.
+ * </p>
+ */
+struct VpPoint
+{
+    VpPoint() : m_x(0), m_y(0) {}
+    VpPoint(int x, int y) : m_x(x), m_y(y) {}
+
+    bool operator==(const VpPoint &point) const
+    { return (m_x == point.m_x) && (m_y == point.m_y); }
+    bool operator!=(const VpPoint &point) const
+    { return (m_x != point.m_x) || (m_y != point.m_y); }
+
+    /** The x component of the coordinate. */
+    int m_x;
+    /** The y component of the coordinate. */
+    int m_y;
+};
+
+/**
+ * The <code>VpRect</code> is an axis aligned rectangle given by its minimum
+ * and maximum coordinates, both inclusive. Like <code>VpPoint</code>, it is a
+ * plain value.
+ */
+struct VpRect
+{
+    VpRect() : m_xmin(0), m_ymin(0), m_xmax(0), m_ymax(0) {}
+    VpRect(int xmin, int ymin, int xmax, int ymax)
+        : m_xmin(xmin), m_ymin(ymin), m_xmax(xmax), m_ymax(ymax) {}
+
+    /**
+     * Determine whether the minimum does not exceed the maximum.
+     */
+    bool isValid() const { return (m_xmin <= m_xmax) && (m_ymin <= m_ymax); }
+
+    bool contains(const VpPoint &point) const
+    {
+        return (point.m_x >= m_xmin) && (point.m_x <= m_xmax) &&
+               (point.m_y >= m_ymin) && (point.m_y <= m_ymax);
+    }
+
+    bool contains(const VpRect &rect) const
+    {
+        return (rect.m_xmin >= m_xmin) && (rect.m_xmax <= m_xmax) &&
+               (rect.m_ymin >= m_ymin) && (rect.m_ymax <= m_ymax);
+    }
+
+    bool intersects(const VpRect &rect) const
+    {
+        return ! ((rect.m_xmin > m_xmax) || (rect.m_xmax < m_xmin) ||
+                  (rect.m_ymin > m_ymax) || (rect.m_ymax < m_ymin));
+    }
+
+    bool operator==(const VpRect &rect) const
+    {
+        return (m_xmin == rect.m_xmin) && (m_ymin == rect.m_ymin) &&
+               (m_xmax == rect.m_xmax) && (m_ymax == rect.m_ymax);
+    }
+    bool operator!=(const VpRect &rect) const { return ! (*this == rect); }
+
+    int m_xmin;
+    int m_ymin;
+    int m_xmax;
+    int m_ymax;
+};
+
+Q_DECLARE_TYPEINFO(VpPoint, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(VpRect, Q_PRIMITIVE_TYPE);
+Q_DECLARE_METATYPE(VpPoint)
+Q_DECLARE_METATYPE(VpRect)
+
+#endif // __VPPOINT_H_
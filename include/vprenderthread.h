@@ -0,0 +1,179 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+#ifndef __VPRENDERTHREAD_H_
+#define __VPRENDERTHREAD_H_
+
+// Include Qt header files.
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QColor>
+#include <QSize>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+#include "vptransform.h"
+#include "vpgrid.h"
+#include "vpgridlayout.h"
+#include "vpdisplaylist.h"
+#include "vpdeadline.h"
+#include "vpgraphics2d.h"
+
+/**
+ * The <code>VpRenderThread</code> class rasterizes the grid and display
+ * list of a <code>VpGraphics2D</code> into an image on a worker thread.
+ * <p>
+ * The GUI thread requests frames with snapshots of the mapping, the grid
+ * and the display list; the snapshots are cheap copies, so the GUI thread
+ * may carry on editing while a frame renders. The display list shares its
+ * storage with the snapshot only until the frame has rendered, so edits
+ * made between frames do not copy it. Only the latest request is
+ * kept: a request made while a frame renders makes that frame stale and
+ * cancels its rendering, and a stale frame is dropped rather than
+ * presented.
+ * </p>
+ * <p>
+ * Frames are triple-buffered. The worker renders into one image while
+ * another holds the latest completed frame, which the GUI thread takes with
+ * <code>getFrame()</code> after <code>frameReady()</code> is signalled. The
+ * GUI thread hands back the frame it held in exchange, so the buffers are
+ * reused rather than shared and no frame is copied.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpRenderThread : public QThread
+{
+    Q_OBJECT
+
+  public:
+
+    /**
+     * A constructor that specifies the parent object.
+     *
+     * @param parent The parent object.
+     */
+    explicit VpRenderThread(QObject *parent = 0);
+
+    /**
+     * @brief The destructor. Stops the worker, abandoning any frame in progress.
+     */
+    virtual ~VpRenderThread();
+
+    /**
+     * Request a frame, replacing any request not yet started.
+     *
+     * @param transform The world to device mapping to render with.
+     * @param mode The coordinate mode the mapping is used in.
+     * @param pw The width of a pixel, in world coordinates.
+     * @param ph The height of a pixel, in world coordinates.
+     * @param size The size of the frame, in device independent pixels.
+     * @param ratio The device pixel ratio of the frame.
+     * @param background The color to clear the frame with.
+     * @param grid The grid to draw; its characteristics are copied.
+     * @param list The display list to draw; it is shared until the frame
+     * has rendered.
+     */
+    void request(const VpTransform &transform, VpGraphics2D::CoordMode mode,
+                 double pw, double ph, const QSize &size, qreal ratio,
+                 const QColor &background, VpGrid &grid, const VpDisplayList &list);
+
+    /**
+     * Take the latest completed frame, in exchange for the one taken last.
+     *
+     * @param image Receives the frame. The image it held is kept for reuse,
+     * so it should not be shared.
+     * @param transform Receives the mapping the frame was rendered with.
+     * @param gridDrawn Receives whether the grid could be drawn.
+     *
+     * @return <b>true</b> is returned if a frame was completed since the
+     * last one was taken. Otherwise, <b>false</b> is returned.
+     */
+    bool getFrame(QImage *image, VpTransform *transform, bool *gridDrawn);
+
+  signals:
+
+    /**
+     * @brief Signal that a frame has been completed. It is emitted from the
+     * worker thread.
+     */
+    void frameReady();
+
+  protected:
+
+    /**
+     * The worker loop; renders the latest request until the thread is
+     * destroyed.
+     */
+    void run();
+
+  private:
+
+    // A frame request.
+    struct Request
+    {
+        VpTransform m_transform;
+        VpGraphics2D::CoordMode m_mode;
+        double m_pw;
+        double m_ph;
+        QSize  m_size;
+        qreal  m_ratio;
+        QColor m_background;
+    };
+
+    /**
+     * Render a request into the back buffer.
+     *
+     * @return <b>true</b> is returned if the grid could be drawn.
+     */
+    bool render(const Request &request);
+
+    // Guards everything shared between the GUI and worker threads.
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    bool m_abort;
+
+    // The latest request, waiting for the worker.
+    bool m_pending;
+    Request m_request;
+    VpGrid *m_requestGrid;
+    VpDisplayList *m_requestList;
+
+    // The snapshots being rendered; used by the worker only.
+    VpGrid *m_workGrid;
+    VpDisplayList *m_workList;
+    VpGridLayout m_layout;
+    QImage m_back;
+    // Stops the grid of the frame being rendered once it is stale.
+    VpDeadline m_deadline;
+
+    // The latest completed frame.
+    bool m_frameReady;
+    QImage m_front;
+    VpTransform m_frontTransform;
+    bool m_frontGridDrawn;
+};
+
+#endif // __VPRENDERTHREAD_H_
@@ -26,10 +26,16 @@
 
 // Include Qt header files.
 #include <QObject>
+#include <QPen>
+#include <QPixmap>
+#include <QPainterPath>
+#include <QHash>
+#include <QTransform>
 
 // Include QtVp header files.
 //#include "qtvp_global.h"
 #include "vpgraphics2d.h"
+#include "vptransform.h"
 
 #define RULER_BREADTH 20
 
@@ -62,13 +68,78 @@ class QTVPSHARED_EXPORT VpRuler : public VpGraphics2D
     void setRulerZoom(const qreal rulerZoom);
     void setCursorPos(const QPoint cursorPos);
     void setExtent(const QRect size, const QPoint origin);
+    void setExtent(const QRectF size, const QPointF origin);
     void setExtentTrack(const bool track);
     void setMouseTrack(const bool track);
 
+    /**
+     * Follow the mapping of the content viewport the ruler measures.
+     * <p>
+     * Along the ruler, the snapshot is used as is, so the ruler and the
+     * content never disagree; across it, one world unit is one pixel. The
+     * ruler keeps following the snapshot, through resizes, until an extent
+     * is set with <code>setExtent()</code>.
+     * </p>
+     *
+     * @param transform A snapshot of the content viewport's mapping.
+     */
+    void setTransform(const VpTransform &transform);
+
   protected:
 
     void mouseMoveEvent(QMouseEvent* event);
     void paintEvent(QPaintEvent* event);
+    void changeEvent(QEvent* event);
+    void resizeEvent(QResizeEvent* event);
+
+    /**
+     * Derive the ruler's mapping from the shared content snapshot.
+     */
+    void applyTransform();
+
+    /**
+     * Get the transform mapping the world coordinate extent onto the
+     * ruler; the vertical ruler is flipped.
+     */
+    QTransform getRulerTransform();
+
+    /**
+     * Move the mouse position indicator, repainting only the areas it
+     * leaves and enters.
+     *
+     * @param pos The cursor position, in ruler coordinates.
+     */
+    void moveCursor(const QPoint &pos);
+
+    /**
+     * Get the area covered by the mouse position indicator.
+     *
+     * @param cursor The cursor position, in ruler coordinates.
+     */
+    QRect getIndicatorRect(const QPoint &cursor);
+
+    /**
+     * Copy an area of the cached tick strip to the ruler.
+     */
+    void copyStrip(QPainter* painter, const QRect &r);
+
+    /**
+     * Determine whether the cached tick strip matches the ruler's size,
+     * extent, origin, unit and zoom.
+     */
+    bool isStripCurrent();
+
+    /**
+     * Render the ticks, labels and border into the cached strip.
+     */
+    void renderStrip();
+
+    /**
+     * Get the outline of a tick label, building it on first use.
+     *
+     * @param value The value of the label.
+     */
+    const QPainterPath &getLabel(int value);
 
   private:
 
@@ -87,6 +158,34 @@ class QTVPSHARED_EXPORT VpRuler : public VpGraphics2D
     bool      m_extentTracking;
     qreal     m_Wx;
     qreal     m_Wy;
+
+    // The content viewport's mapping, if the ruler follows it.
+    bool        m_sharing;
+    VpTransform m_sharedTransform;
+
+    // The pens are built once rather than on every paint.
+    QPen      m_tickPen;
+    QPen      m_borderPen;
+
+    // The pixels either side of the indicator repainted when it moves.
+    static const int INDICATOR_MARGIN = 2;
+
+    // The most labels kept in the cache.
+    static const int MAX_LABELS = 256;
+
+    // The ticks, labels and border, rendered once per change of mapping.
+    QPixmap   m_strip;
+    // The state the strip was rendered for.
+    bool      m_stripValid;
+    double    m_stripWxmin;
+    double    m_stripWymin;
+    double    m_stripWxmax;
+    double    m_stripWymax;
+    qreal     m_stripOrigin;
+    qreal     m_stripUnit;
+    qreal     m_stripZoom;
+    // The label outlines, by value.
+    QHash<int, QPainterPath> m_labels;
 };
 
 #endif // __VPRULER_H_
@@ -0,0 +1,244 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+#ifndef __VPSPATIALINDEX_H_
+#define __VPSPATIALINDEX_H_
+
+// Include Qt header files.
+#include <QVector>
+#include <QRectF>
+#include <QPointF>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+
+/**
+ * The <code>VpSpatialIndex</code> class is an R-tree over world coordinate
+ * bounding boxes, each identified by an integer id.
+ * <p>
+ * The tree may be bulk loaded with Sort-Tile-Recursive packing, which
+ * gives nearly full nodes with little overlap, and then kept up to date
+ * with incremental insertions and removals. Queries visit only the nodes
+ * whose bounds meet the query, so their cost grows with the number of
+ * results rather than the number of items.
+ * </p>
+ * <p>
+ * Boxes are closed: a box touching the query rectangle on an edge
+ * intersects it. Boxes may be degenerate, such as those of points.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpSpatialIndex
+{
+  public:
+
+    // The maximum number of entries of a node.
+    static const int MAX_ENTRIES = 16;
+    // The minimum number of entries of a node other than the root.
+    static const int MIN_ENTRIES = 6;
+
+    // A bounding box and the item, or within the tree the node, it bounds.
+    struct Entry
+    {
+        double m_xmin;
+        double m_ymin;
+        double m_xmax;
+        double m_ymax;
+        int    m_id;
+    };
+
+    /**
+     * @brief Default constructor. Creates an empty index.
+     */
+    VpSpatialIndex();
+
+    /**
+     * @brief The destructor.
+     */
+    virtual ~VpSpatialIndex();
+
+    /**
+     * @brief Remove all items.
+     */
+    void clear();
+
+    /**
+     * Replace the contents of the index, packing the items with
+     * Sort-Tile-Recursive bulk loading.
+     *
+     * @param items The items and their bounding boxes.
+     */
+    void load(const QVector<Entry> &items);
+
+    /**
+     * Add an item.
+     *
+     * @param id The item id.
+     * @param xmin The minimum x component of the bounding box.
+     * @param ymin The minimum y component of the bounding box.
+     * @param xmax The maximum x component of the bounding box.
+     * @param ymax The maximum y component of the bounding box.
+     */
+    void insert(int id, double xmin, double ymin, double xmax, double ymax);
+
+    /**
+     * Remove an item. The bounding box must be exactly the one the item
+     * was inserted with; it guides the search for the item.
+     *
+     * @param id The item id.
+     * @param xmin The minimum x component of the bounding box.
+     * @param ymin The minimum y component of the bounding box.
+     * @param xmax The maximum x component of the bounding box.
+     * @param ymax The maximum y component of the bounding box.
+     *
+     * @return <b>true</b> is returned if the item was found. Otherwise,
+     * <b>false</b> is returned.
+     */
+    bool remove(int id, double xmin, double ymin, double xmax, double ymax);
+
+    /**
+     * Get the number of items.
+     */
+    int getCount() const { return m_count; }
+
+    /**
+     * Get the bounds of all items. An empty index has null bounds.
+     */
+    QRectF getBounds() const;
+
+    /**
+     * Find the items whose bounding boxes intersect a rectangle.
+     *
+     * @param rect The query rectangle.
+     * @param ids The ids of the items found are appended to this.
+     */
+    void query(const QRectF &rect, QVector<int> *ids) const;
+
+    /**
+     * Find the items whose bounding boxes lie within a rectangle.
+     *
+     * @param rect The query rectangle.
+     * @param ids The ids of the items found are appended to this.
+     */
+    void queryContained(const QRectF &rect, QVector<int> *ids) const;
+
+    /**
+     * Find the items whose bounding boxes contain a point.
+     *
+     * @param point The query point.
+     * @param ids The ids of the items found are appended to this.
+     */
+    void query(const QPointF &point, QVector<int> *ids) const;
+
+  protected:
+
+    // A node of the tree. Leaf entries hold item ids, the entries of
+    // other nodes hold child node indices. There is room for one extra
+    // entry while a node is being split.
+    struct Node
+    {
+        int    m_count;
+        bool   m_leaf;
+        double m_xmin[MAX_ENTRIES + 1];
+        double m_ymin[MAX_ENTRIES + 1];
+        double m_xmax[MAX_ENTRIES + 1];
+        double m_ymax[MAX_ENTRIES + 1];
+        int    m_child[MAX_ENTRIES + 1];
+    };
+
+    /**
+     * Allocate an empty node, reusing a freed one if possible.
+     *
+     * @return The node index is returned.
+     */
+    int allocNode(bool leaf);
+
+    /**
+     * Free a node and, recursively, its children, appending the entries
+     * of the leaves to <code>orphans</code> if it is not <b>NULL</b>.
+     */
+    void freeNode(int node, QVector<Entry> *orphans);
+
+    /**
+     * Get the bounds of the entries of a node.
+     */
+    Entry getNodeBounds(int node) const;
+
+    /**
+     * Add an entry to a node.
+     */
+    void appendEntry(int node, const Entry &entry);
+
+    /**
+     * Insert a leaf entry without counting it as a new item.
+     */
+    void insertItem(const Entry &entry);
+
+    /**
+     * Insert a leaf entry below a node.
+     *
+     * @return The index of the node split off from <code>node</code> is
+     * returned, or -1 if it was not split.
+     */
+    int insertEntry(int node, const Entry &entry);
+
+    /**
+     * Split an overfull node in two.
+     *
+     * @return The index of the new node is returned.
+     */
+    int splitNode(int node);
+
+    /**
+     * Remove an item from below a node, collecting the leaf entries of
+     * underfull nodes in <code>orphans</code>.
+     */
+    bool removeEntry(int node, const Entry &entry, QVector<Entry> *orphans);
+
+    /**
+     * Pack a level of entries into nodes with Sort-Tile-Recursive.
+     *
+     * @return The entries of the new nodes are returned.
+     */
+    QVector<Entry> packLevel(QVector<Entry> &entries, bool leaf);
+
+    /**
+     * Find the items below the root whose boxes meet a rectangle.
+     */
+    void search(double xmin, double ymin, double xmax, double ymax,
+                bool contained, QVector<int> *ids) const;
+
+  protected:
+
+    // The node pool and the free nodes in it.
+    QVector<Node> m_nodes;
+    QVector<int>  m_freeNodes;
+    // The root node, or -1 if the index is empty.
+    int m_root;
+    // The number of items.
+    int m_count;
+};
+
+#endif // __VPSPATIALINDEX_H_
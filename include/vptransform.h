@@ -0,0 +1,233 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+#ifndef __VPTRANSFORM_H_
+#define __VPTRANSFORM_H_
+
+// Include Qt header files.
+#include <QTransform>
+#include <QMetaType>
+
+// Include QtVp header files.
+#include "qtvp_global.h"
+#include "vputil.h"
+
+/**
+ * The <code>VpTransform</code> class is a snapshot of the mapping between
+ * the world and device coordinate spaces of a <code>VpGraphics2D</code>.
+ * <p>
+ * A snapshot is a plain value: it is cheap to copy, never changes once
+ * taken and may be used from any thread. Each new mapping published by a
+ * viewport carries a higher version number.
+ * </p>
+ * <p>
+ * All mappings, integer or not, are carried out in double precision from
+ * the same scale and offset as the matrices the viewport paints and picks
+ * with. The inverse mapping is computed once per snapshot, so mapping
+ * device coordinates back to world coordinates multiplies instead of
+ * divides, exactly as the viewport and its kernels do.
+ * </p>
+ *
+ * @author Mark S. Millard
+ */
+class QTVPSHARED_EXPORT VpTransform
+{
+  public:
+
+    /**
+     * @brief Default constructor. Creates an empty snapshot with version 0.
+     */
+    VpTransform();
+
+    /**
+     * A constructor that specifies the complete mapping.
+     *
+     * @param wxmin The minimum x component of the world extent.
+     * @param wymin The minimum y component of the world extent.
+     * @param wxmax The maximum x component of the world extent.
+     * @param wymax The maximum y component of the world extent.
+     * @param xscale The x scale factor from world to device.
+     * @param yscale The y scale factor from world to device.
+     * @param xoffset The x offset from world to device.
+     * @param yoffset The y offset from world to device.
+     * @param version The version of the mapping.
+     */
+    VpTransform(int wxmin, int wymin, int wxmax, int wymax,
+                float xscale, float yscale, float xoffset, float yoffset,
+                unsigned int version);
+
+    // Accessors for the mapping.
+    int getWxmin() const { return m_wxmin; }
+    int getWymin() const { return m_wymin; }
+    int getWxmax() const { return m_wxmax; }
+    int getWymax() const { return m_wymax; }
+    float getXScale() const { return m_xscale; }
+    float getYScale() const { return m_yscale; }
+    float getXOffset() const { return m_xoffset; }
+    float getYOffset() const { return m_yoffset; }
+    unsigned int getVersion() const { return m_version; }
+    double getWxminF() const { return m_wxminF; }
+    double getWyminF() const { return m_wyminF; }
+    double getWxmaxF() const { return m_wxmaxF; }
+    double getWymaxF() const { return m_wymaxF; }
+    double getXScaleF() const { return m_xscaleF; }
+    double getYScaleF() const { return m_yscaleF; }
+    double getXOffsetF() const { return m_xoffsetF; }
+    double getYOffsetF() const { return m_yoffsetF; }
+    float getXInvScale() const { return m_xinvscale; }
+    float getYInvScale() const { return m_yinvscale; }
+
+    /**
+     * Get the world to device mapping as an affine matrix. This is the
+     * matrix the viewport renders with.
+     */
+    QTransform getWorldToDevMatrix() const
+    {
+        if ((m_xscaleF == 0) || (m_yscaleF == 0))
+            return QTransform();
+        return QTransform(m_xscaleF, 0, 0, m_yscaleF, m_xoffsetF, m_yoffsetF);
+    }
+
+    /**
+     * Get the device to world mapping as an affine matrix; the inverse of
+     * <code>getWorldToDevMatrix()</code>.
+     */
+    QTransform getDevToWorldMatrix() const
+    {
+        if ((m_xscaleF == 0) || (m_yscaleF == 0))
+            return QTransform();
+        return QTransform(m_xinvscaleF, 0, 0, m_yinvscaleF, m_xinvoffsetF, m_yinvoffsetF);
+    }
+
+    /**
+     * Set the double precision world extent of the snapshot.
+     *
+     * @param wxmin The minimum x component of the world extent.
+     * @param wymin The minimum y component of the world extent.
+     * @param wxmax The maximum x component of the world extent.
+     * @param wymax The maximum y component of the world extent.
+     */
+    void setExtentF(double wxmin, double wymin, double wxmax, double wymax);
+
+    /**
+     * Set the double precision mapping of the snapshot, deriving the
+     * inverse mapping from it.
+     *
+     * @param xscale The x scale factor from world to device.
+     * @param yscale The y scale factor from world to device.
+     * @param xoffset The x offset from world to device.
+     * @param yoffset The y offset from world to device.
+     */
+    void setMappingF(double xscale, double yscale, double xoffset, double yoffset);
+
+    /**
+     * Convert the specified world coordinate to device coordinate. The
+     * result is that of <code>getWorldToDevMatrix()</code>, rounded, and is
+     * identical to <code>VpGraphics2D::worldToDev()</code> in
+     * <code>COORD_INT</code> mode.
+     *
+     * @param x The x component of the world coordinate.
+     * @param y The y component of the world coordinate.
+     */
+    void worldToDev(int *x, int *y) const
+    {
+        double fx = ((*x) * m_xscaleF) + m_xoffsetF;
+        double fy = ((*y) * m_yscaleF) + m_yoffsetF;
+        *x = VpUtil::round(fx);
+        *y = VpUtil::round(fy);
+    }
+
+    /**
+     * Convert the specified device coordinate to world coordinate. The
+     * result is that of <code>getDevToWorldMatrix()</code>, rounded, and is
+     * identical to <code>VpGraphics2D::devToWorld()</code> in
+     * <code>COORD_INT</code> mode.
+     *
+     * @param x The x component of the device coordinate.
+     * @param y The y component of the device coordinate.
+     */
+    void devToWorld(int *x, int *y) const
+    {
+        double fx = ((*x) * m_xinvscaleF) + m_xinvoffsetF;
+        double fy = ((*y) * m_yinvscaleF) + m_yinvoffsetF;
+        *x = VpUtil::round(fx);
+        *y = VpUtil::round(fy);
+    }
+
+    /**
+     * Convert the specified world coordinate to device coordinate in double
+     * precision, without rounding the result.
+     *
+     * @param x The x component of the world coordinate.
+     * @param y The y component of the world coordinate.
+     */
+    void worldToDev(double *x, double *y) const
+    {
+        *x = ((*x) * m_xscaleF) + m_xoffsetF;
+        *y = ((*y) * m_yscaleF) + m_yoffsetF;
+    }
+
+    /**
+     * Convert the specified device coordinate to world coordinate in double
+     * precision, without rounding the result.
+     *
+     * @param x The x component of the device coordinate.
+     * @param y The y component of the device coordinate.
+     */
+    void devToWorld(double *x, double *y) const
+    {
+        *x = ((*x) * m_xinvscaleF) + m_xinvoffsetF;
+        *y = ((*y) * m_yinvscaleF) + m_yinvoffsetF;
+    }
+
+  private:
+
+    int   m_wxmin;
+    int   m_wymin;
+    int   m_wxmax;
+    int   m_wymax;
+    float m_xscale;
+    float m_yscale;
+    float m_xoffset;
+    float m_yoffset;
+    unsigned int m_version;
+    double m_wxminF;
+    double m_wyminF;
+    double m_wxmaxF;
+    double m_wymaxF;
+    double m_xscaleF;
+    double m_yscaleF;
+    double m_xoffsetF;
+    double m_yoffsetF;
+    float  m_xinvscale;
+    float  m_yinvscale;
+    double m_xinvscaleF;
+    double m_yinvscaleF;
+    double m_xinvoffsetF;
+    double m_yinvoffsetF;
+};
+
+Q_DECLARE_TYPEINFO(VpTransform, Q_MOVABLE_TYPE);
+Q_DECLARE_METATYPE(VpTransform)
+
+#endif // __VPTRANSFORM_H_
@@ -21,7 +21,8 @@ class QTVPSHARED_EXPORT VpUtil
      * @return A value will be returned, rounded to the nearest
      * integer.
      */
-    static int round(double value);
+    static int round(double value)
+    { return ((int) ((value) < 0.0 ? (value) - 0.5 : (value) + 0.5)); }
 };
 
 #endif // __VPUTIL_H_
@@ -0,0 +1,48 @@
+# The library sources, shared by the library and its tests.
+
+INCLUDEPATH += $$PWD/include
+
+SOURCES += $$PWD/src/vpruler.cpp \
+    $$PWD/src/vpcolor.cpp \
+    $$PWD/src/vputil.cpp \
+    $$PWD/src/vpkernels.cpp \
+    $$PWD/src/vptransform.cpp \
+    $$PWD/src/vpcoord.cpp \
+    $$PWD/src/vpgc.cpp \
+    $$PWD/src/vpviewport.cpp \
+    $$PWD/src/vpgraphics2d.cpp \
+    $$PWD/src/vpgrid.cpp \
+    $$PWD/src/vpdeadline.cpp \
+    $$PWD/src/vpgridtilecache.cpp \
+    $$PWD/src/vpgridlayout.cpp \
+    $$PWD/src/vpdisplaylist.cpp \
+    $$PWD/src/vpspatialindex.cpp \
+    $$PWD/src/vprenderthread.cpp \
+    $$PWD/src/vpgriddialog.cpp \
+    $$PWD/src/vpgraphicsview.cpp \
+    $$PWD/src/gridgc.cpp
+
+HEADERS += $$PWD/include/vpcoord.h \
+    $$PWD/include/vppoint.h \
+    $$PWD/include/vpgc.h \
+    $$PWD/include/vpviewport.h \
+    $$PWD/include/vpgraphics2d.h \
+    $$PWD/include/vpgrid.h \
+    $$PWD/include/vpdeadline.h \
+    $$PWD/include/vpgridtilecache.h \
+    $$PWD/include/vpgridlayout.h \
+    $$PWD/include/vpdisplaylist.h \
+    $$PWD/include/vpspatialindex.h \
+    $$PWD/include/vprenderthread.h \
+    $$PWD/include/vpgriddialog.h \
+    $$PWD/include/vpgraphicsview.h \
+    $$PWD/include/vputil.h \
+    $$PWD/include/vpkernels.h \
+    $$PWD/include/vptransform.h \
+    $$PWD/include/vptypes.h \
+    $$PWD/include/vpruler.h \
+    $$PWD/include/vpcolor.h \
+    $$PWD/include/qtvp_global.h \
+    $$PWD/include/gridgc.h
+
+FORMS   += $$PWD/src/vpgriddialog.ui
@@ -25,6 +25,7 @@
 #include "gridgc.h"
 
 GridGC::GridGC()
+  : m_opacity(1.0), m_deadline(NULL)
 {
 }
 
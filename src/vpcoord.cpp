@@ -32,17 +32,15 @@ int VpCoord::g_resolution = 1;
 
 
 VpCoord::VpCoord(int x, int y, int z)
-    : m_x(x), m_y(y), m_z(z)
+    : m_point(x, y), m_z(z)
 {
     // Do nothing extra.
 }
 
-VpCoord::VpCoord(const VpCoord &coord)
+VpCoord::VpCoord(const VpPoint &point, const QString &name)
+    : m_point(point), m_z(0), m_name(name)
 {
-    m_x = coord.m_x;
-    m_y = coord.m_y;
-    m_z = coord.m_z;
-    m_name = coord.m_name;
+    // Do nothing extra.
 }
 
 VpCoord::~VpCoord()
@@ -62,32 +60,17 @@ int VpCoord::worldToInternal(const double x)
 
 const QString VpCoord::toString()
 {
-    char buffer[64];
+    QString coord = QString("(%1,%2,%3").arg(m_point.m_x).arg(m_point.m_y).arg(m_z);
 
-    if (m_name.isNull() || m_name.isEmpty()) {
+    if (! m_name.isEmpty()) {
         // Add the viewport name as part of the coordinate string.
-        sprintf_s(buffer, "(%d,%d,%d,%s)", m_x, m_y, m_z, m_name.toUtf8());
-    } else {
-        // Else close off the coordinate string.
-        sprintf_s(buffer, "(%d,%d,%d)", m_x, m_y, m_z);
-    }
-
-    QString *coord = new QString(buffer);
-    return *coord;
-}
-
-VpCoord & VpCoord::operator=(const VpCoord & coord)
-{
-    if (this != &coord)
-    {
-        m_x = coord.m_x;
-        m_y = coord.m_y;
-        m_z = coord.m_z;
-        m_name = coord.m_name;
+        coord.append(',');
+        coord.append(m_name);
     }
 
-    // By convention, always return *this.
-    return *this;
+    // Close off the coordinate string.
+    coord.append(')');
+    return coord;
 }
 
 bool VpCoord::operator==(const VpCoord & coord) const
@@ -96,7 +79,7 @@ bool VpCoord::operator==(const VpCoord & coord) const
 
     if (this != &coord)
     {
-        if ((m_x == coord.m_x) && (m_y == coord.m_y) &&
+        if ((m_point == coord.m_point) &&
             (m_z == coord.m_z) && (m_name == coord.m_name))
             retValue = true;
         else
@@ -112,7 +95,7 @@ bool VpCoord::operator!=(const VpCoord & coord) const
 
     if (this != &coord)
     {
-        if ((m_x != coord.m_x) || (m_y != coord.m_y) ||
+        if ((m_point != coord.m_point) ||
             (m_z != coord.m_z) || (m_name != coord.m_name))
             retValue = true;
         else
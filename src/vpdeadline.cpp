@@ -0,0 +1,55 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include QtVp header files.
+#include "vpdeadline.h"
+
+VpDeadline::VpDeadline()
+    : m_budget(0), m_cancelled(0), m_stopped(false)
+{
+    // Do nothing extra.
+}
+
+void VpDeadline::start(int budget)
+{
+    m_budget = budget;
+    m_cancelled.storeRelease(0);
+    m_stopped = false;
+    if (budget > 0)
+        m_timer.start();
+}
+
+void VpDeadline::cancel()
+{
+    m_cancelled.storeRelease(1);
+}
+
+bool VpDeadline::hasExpired()
+{
+    if (! m_stopped)
+    {
+        m_stopped = (m_cancelled.loadAcquire() != 0) ||
+                    ((m_budget > 0) && (m_timer.elapsed() >= m_budget));
+    }
+    return m_stopped;
+}
@@ -0,0 +1,766 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+// Include Qt header files.
+#include <QPainter>
+#include <QTransform>
+#include <algorithm>
+
+// Include QtVp header files.
+#include "vpdisplaylist.h"
+
+// The vertex pool is compacted once this many entries are unused and they
+// make up more than half of it.
+static const int g_minGarbage = 1024;
+
+// Determine whether a segment meets a rectangle, by clipping it to the
+// rectangle (Liang-Barsky).
+static bool segmentMeetsRect(const QPointF &p, const QPointF &q,
+                             double xmin, double ymin, double xmax, double ymax)
+{
+    double dx = q.x() - p.x();
+    double dy = q.y() - p.y();
+    double pk[4] = { -dx, dx, -dy, dy };
+    double qk[4] = { p.x() - xmin, xmax - p.x(), p.y() - ymin, ymax - p.y() };
+    double t0 = 0, t1 = 1;
+
+    for (int k = 0; k < 4; k++)
+    {
+        if (pk[k] == 0)
+        {
+            // Parallel to this edge; reject if outside it.
+            if (qk[k] < 0)
+                return false;
+            continue;
+        }
+
+        double t = qk[k] / pk[k];
+        if (pk[k] < 0)
+        {
+            if (t > t1)
+                return false;
+            if (t > t0)
+                t0 = t;
+        } else
+        {
+            if (t < t0)
+                return false;
+            if (t < t1)
+                t1 = t;
+        }
+    }
+    return true;
+}
+
+// Determine whether a point lies inside a polygon, by the even-odd rule.
+static bool pointInPolygon(double x, double y, const QPointF *points, int count)
+{
+    bool inside = false;
+    for (int i = 0, j = count - 1; i < count; j = i++)
+    {
+        const QPointF &a = points[i];
+        const QPointF &b = points[j];
+        if (((a.y() > y) != (b.y() > y)) &&
+            (x < (b.x() - a.x()) * (y - a.y()) / (b.y() - a.y()) + a.x()))
+            inside = ! inside;
+    }
+    return inside;
+}
+
+// Get the square of the distance from the origin to a segment.
+static double segmentDistance2(double ax, double ay, double bx, double by)
+{
+    double dx = bx - ax;
+    double dy = by - ay;
+    double length2 = dx * dx + dy * dy;
+    double t = (length2 > 0) ? -(ax * dx + ay * dy) / length2 : 0;
+    t = qBound(0.0, t, 1.0);
+    double x = ax + t * dx;
+    double y = ay + t * dy;
+    return x * x + y * y;
+}
+
+VpDisplayStyle::VpDisplayStyle()
+    : m_pen(Qt::black, 0), m_brush(Qt::NoBrush),
+      m_marker(MARKER_SQUARE), m_markerSize(5)
+{
+    m_pen.setCosmetic(true);
+}
+
+VpDisplayList::VpDisplayList(QObject *parent)
+    : QObject(parent), m_garbage(0), m_itemCount(0)
+{
+    // Style 0 is always available.
+    addStyle(VpDisplayStyle());
+}
+
+VpDisplayList::~VpDisplayList()
+{
+    // Do nothing.
+}
+
+void VpDisplayList::copy(const VpDisplayList &list)
+{
+    // The drawing and picking buffers are private to each list.
+    m_types = list.m_types;
+    m_generations = list.m_generations;
+    m_styleIds = list.m_styleIds;
+    m_xmin = list.m_xmin;
+    m_ymin = list.m_ymin;
+    m_xmax = list.m_xmax;
+    m_ymax = list.m_ymax;
+    m_first = list.m_first;
+    m_count = list.m_count;
+    m_points = list.m_points;
+    m_garbage = list.m_garbage;
+    m_index = list.m_index;
+    m_texts = list.m_texts;
+    m_free = list.m_free;
+    m_itemCount = list.m_itemCount;
+    m_styles = list.m_styles;
+}
+
+void VpDisplayList::release()
+{
+    // Assign empty storage rather than clearing it, which would detach.
+    m_types = QVector<quint8>();
+    m_generations = QVector<quint32>();
+    m_styleIds = QVector<int>();
+    m_xmin = QVector<double>();
+    m_ymin = QVector<double>();
+    m_xmax = QVector<double>();
+    m_ymax = QVector<double>();
+    m_first = QVector<int>();
+    m_count = QVector<int>();
+    m_points = QVector<QPointF>();
+    m_garbage = 0;
+    m_index = VpSpatialIndex();
+    m_texts = QHash<int, QString>();
+    m_free = QVector<int>();
+    m_itemCount = 0;
+}
+
+int VpDisplayList::addStyle(const VpDisplayStyle &style)
+{
+    m_styles.append(style);
+    m_styles.last().m_pen.setCosmetic(true);
+    return m_styles.size() - 1;
+}
+
+bool VpDisplayList::setStyle(int id, const VpDisplayStyle &style)
+{
+    if ((id < 0) || (id >= m_styles.size()))
+        return false;
+
+    m_styles[id] = style;
+    m_styles[id].m_pen.setCosmetic(true);
+    emit changed();
+    return true;
+}
+
+int VpDisplayList::slotOf(Handle item) const
+{
+    // Declare local variables.
+    int slot = (int) (item & 0xffffffff);
+    quint32 generation = (quint32) (item >> 32);
+
+    if ((slot < 0) || (slot >= m_types.size()) ||
+        (m_generations.at(slot) != generation) || (m_types.at(slot) == ITEM_NONE))
+        return -1;
+    return slot;
+}
+
+bool VpDisplayList::isValid(Handle item) const
+{
+    return (slotOf(item) >= 0);
+}
+
+VpDisplayList::Type VpDisplayList::getType(Handle item) const
+{
+    int slot = slotOf(item);
+    return (slot >= 0) ? (Type) m_types.at(slot) : ITEM_NONE;
+}
+
+QRectF VpDisplayList::getBounds(Handle item) const
+{
+    int slot = slotOf(item);
+    if (slot < 0)
+        return QRectF();
+    return QRectF(QPointF(m_xmin.at(slot), m_ymin.at(slot)),
+                  QPointF(m_xmax.at(slot), m_ymax.at(slot)));
+}
+
+int VpDisplayList::allocate(Type type, int style, const QPointF *points, int count)
+{
+    // Declare local variables.
+    int slot;
+
+    if (! m_free.isEmpty())
+    {
+        // Reuse a slot; its generation was advanced when it was freed.
+        slot = m_free.last();
+        m_free.removeLast();
+    } else
+    {
+        slot = m_types.size();
+        m_types.append(ITEM_NONE);
+        m_generations.append(1);
+        m_styleIds.append(0);
+        m_xmin.append(0);
+        m_ymin.append(0);
+        m_xmax.append(0);
+        m_ymax.append(0);
+        m_first.append(0);
+        m_count.append(0);
+    }
+
+    m_types[slot] = (quint8) type;
+    m_styleIds[slot] = ((style >= 0) && (style < m_styles.size())) ? style : 0;
+    m_count[slot] = 0;
+    storePoints(slot, points, count);
+    m_itemCount++;
+
+    return slot;
+}
+
+void VpDisplayList::storePoints(int slot, const QPointF *points, int count)
+{
+    // Declare local variables.
+    double xmin, ymin, xmax, ymax;
+
+    // Every item has vertices, so a slot with none is not indexed.
+    if (m_count.at(slot) > 0)
+        m_index.remove(slot, m_xmin.at(slot), m_ymin.at(slot), m_xmax.at(slot), m_ymax.at(slot));
+
+    if (m_count.at(slot) >= count)
+    {
+        // The new vertices fit where the old ones were.
+        m_garbage += m_count.at(slot) - count;
+    } else
+    {
+        m_garbage += m_count.at(slot);
+        m_first[slot] = m_points.size();
+        m_points.resize(m_points.size() + count);
+    }
+    m_count[slot] = count;
+
+    QPointF *dst = m_points.data() + m_first.at(slot);
+    xmin = xmax = (count > 0) ? points[0].x() : 0;
+    ymin = ymax = (count > 0) ? points[0].y() : 0;
+    for (int i = 0; i < count; i++)
+    {
+        dst[i] = points[i];
+        xmin = qMin(xmin, points[i].x());
+        xmax = qMax(xmax, points[i].x());
+        ymin = qMin(ymin, points[i].y());
+        ymax = qMax(ymax, points[i].y());
+    }
+    m_xmin[slot] = xmin;
+    m_ymin[slot] = ymin;
+    m_xmax[slot] = xmax;
+    m_ymax[slot] = ymax;
+    m_index.insert(slot, xmin, ymin, xmax, ymax);
+
+    compact();
+}
+
+void VpDisplayList::compact()
+{
+    if ((m_garbage < g_minGarbage) || (m_garbage * 2 < m_points.size()))
+        return;
+
+    // Copy the live vertices into a new pool, in slot order.
+    QVector<QPointF> pool;
+    pool.reserve(m_points.size() - m_garbage);
+    for (int slot = 0; slot < m_types.size(); slot++)
+    {
+        if (m_types.at(slot) == ITEM_NONE)
+            continue;
+        int first = pool.size();
+        pool.resize(first + m_count.at(slot));
+        const QPointF *src = m_points.constData() + m_first.at(slot);
+        QPointF *dst = pool.data() + first;
+        for (int i = 0; i < m_count.at(slot); i++)
+            dst[i] = src[i];
+        m_first[slot] = first;
+    }
+    m_points = pool;
+    m_garbage = 0;
+}
+
+VpDisplayList::Handle VpDisplayList::addLine(const QPointF &p1, const QPointF &p2, int style)
+{
+    QPointF points[2] = { p1, p2 };
+    int slot = allocate(ITEM_LINE, style, points, 2);
+    emit changed();
+    return handleOf(slot);
+}
+
+VpDisplayList::Handle VpDisplayList::addPolyline(const QPolygonF &points, int style)
+{
+    if (points.size() < 2)
+        return 0;
+    int slot = allocate(ITEM_POLYLINE, style, points.constData(), points.size());
+    emit changed();
+    return handleOf(slot);
+}
+
+VpDisplayList::Handle VpDisplayList::addRect(const QRectF &rect, int style)
+{
+    QPointF points[2] = { rect.topLeft(), rect.bottomRight() };
+    int slot = allocate(ITEM_RECT, style, points, 2);
+    emit changed();
+    return handleOf(slot);
+}
+
+VpDisplayList::Handle VpDisplayList::addPolygon(const QPolygonF &points, int style)
+{
+    if (points.size() < 3)
+        return 0;
+    int slot = allocate(ITEM_POLYGON, style, points.constData(), points.size());
+    emit changed();
+    return handleOf(slot);
+}
+
+VpDisplayList::Handle VpDisplayList::addText(const QPointF &anchor, const QString &text, int style)
+{
+    int slot = allocate(ITEM_TEXT, style, &anchor, 1);
+    m_texts.insert(slot, text);
+    emit changed();
+    return handleOf(slot);
+}
+
+VpDisplayList::Handle VpDisplayList::addMarker(const QPointF &anchor, int style)
+{
+    int slot = allocate(ITEM_MARKER, style, &anchor, 1);
+    emit changed();
+    return handleOf(slot);
+}
+
+bool VpDisplayList::setPoints(Handle item, const QPolygonF &points)
+{
+    // Declare local variables.
+    int slot = slotOf(item);
+    bool fits;
+
+    if (slot < 0)
+        return false;
+
+    switch (m_types.at(slot))
+    {
+        case ITEM_LINE:
+        case ITEM_RECT:
+            fits = (points.size() == 2);
+            break;
+        case ITEM_POLYLINE:
+            fits = (points.size() >= 2);
+            break;
+        case ITEM_POLYGON:
+            fits = (points.size() >= 3);
+            break;
+        default:
+            fits = (points.size() == 1);
+            break;
+    }
+    if (! fits)
+        return false;
+
+    storePoints(slot, points.constData(), points.size());
+    emit changed();
+    return true;
+}
+
+bool VpDisplayList::setText(Handle item, const QString &text)
+{
+    int slot = slotOf(item);
+    if ((slot < 0) || (m_types.at(slot) != ITEM_TEXT))
+        return false;
+
+    m_texts.insert(slot, text);
+    emit changed();
+    return true;
+}
+
+bool VpDisplayList::setItemStyle(Handle item, int style)
+{
+    int slot = slotOf(item);
+    if ((slot < 0) || (style < 0) || (style >= m_styles.size()))
+        return false;
+
+    m_styleIds[slot] = style;
+    emit changed();
+    return true;
+}
+
+bool VpDisplayList::remove(Handle item)
+{
+    int slot = slotOf(item);
+    if (slot < 0)
+        return false;
+
+    m_index.remove(slot, m_xmin.at(slot), m_ymin.at(slot), m_xmax.at(slot), m_ymax.at(slot));
+
+    // Advance the generation so the handle, and any copy of it, is stale.
+    m_types[slot] = ITEM_NONE;
+    if (++m_generations[slot] == 0)
+        m_generations[slot] = 1;
+    m_garbage += m_count.at(slot);
+    m_count[slot] = 0;
+    m_texts.remove(slot);
+    m_free.append(slot);
+    m_itemCount--;
+
+    compact();
+    emit changed();
+    return true;
+}
+
+void VpDisplayList::clear()
+{
+    // Keep the slots, with advanced generations, so old handles stay stale.
+    m_free.resize(0);
+    for (int slot = m_types.size() - 1; slot >= 0; slot--)
+    {
+        if (m_types.at(slot) != ITEM_NONE)
+        {
+            m_types[slot] = ITEM_NONE;
+            if (++m_generations[slot] == 0)
+                m_generations[slot] = 1;
+        }
+        m_count[slot] = 0;
+        m_free.append(slot);
+    }
+    m_points.clear();
+    m_texts.clear();
+    m_index.clear();
+    m_garbage = 0;
+    m_itemCount = 0;
+
+    emit changed();
+}
+
+void VpDisplayList::query(const QRectF &rect, QVector<Handle> *items)
+{
+    m_hits.resize(0);
+    m_index.query(rect, &m_hits);
+    for (int i = 0; i < m_hits.size(); i++)
+        items->append(handleOf(m_hits.at(i)));
+}
+
+void VpDisplayList::select(const QRectF &rect, bool contained, QVector<Handle> *items)
+{
+    // Declare local variables.
+    QRectF r = rect.normalized();
+
+    m_hits.resize(0);
+    if (contained)
+    {
+        // A bounding box within the rectangle means the geometry is too.
+        m_index.queryContained(r, &m_hits);
+        for (int i = 0; i < m_hits.size(); i++)
+            items->append(handleOf(m_hits.at(i)));
+        return;
+    }
+
+    // The index finds the candidates, the geometry decides.
+    m_index.query(r, &m_hits);
+    for (int i = 0; i < m_hits.size(); i++)
+    {
+        if (intersects(m_hits.at(i), r.left(), r.top(), r.right(), r.bottom()))
+            items->append(handleOf(m_hits.at(i)));
+    }
+}
+
+bool VpDisplayList::intersects(int slot, double xmin, double ymin, double xmax, double ymax) const
+{
+    const QPointF *p = m_points.constData() + m_first.at(slot);
+    int count = m_count.at(slot);
+
+    switch (m_types.at(slot))
+    {
+        case ITEM_LINE:
+        case ITEM_POLYLINE:
+            for (int i = 1; i < count; i++)
+            {
+                if (segmentMeetsRect(p[i - 1], p[i], xmin, ymin, xmax, ymax))
+                    return true;
+            }
+            return false;
+        case ITEM_POLYGON:
+            for (int i = 0, j = count - 1; i < count; j = i++)
+            {
+                if (segmentMeetsRect(p[j], p[i], xmin, ymin, xmax, ymax))
+                    return true;
+            }
+            // No edge meets the rectangle, so one may enclose the other.
+            return pointInPolygon(xmin, ymin, p, count) ||
+                   ((p[0].x() >= xmin) && (p[0].x() <= xmax) &&
+                    (p[0].y() >= ymin) && (p[0].y() <= ymax));
+        default:
+            // The bounding box is the geometry.
+            return true;
+    }
+}
+
+VpDisplayList::Handle VpDisplayList::pick(const QPointF &point, int tolerance, const QTransform &matrix)
+{
+    // Declare local variables.
+    double sx = qAbs(matrix.m11());
+    double sy = qAbs(matrix.m22());
+    double markerSize = 0;
+    double best;
+    int hit = -1;
+
+    if ((sx == 0) || (sy == 0) || (tolerance < 0))
+        return 0;
+
+    // Markers extend beyond their anchor; widen the search to cover them.
+    for (int i = 0; i < m_styles.size(); i++)
+        markerSize = qMax(markerSize, (double) m_styles.at(i).m_markerSize);
+    double reach = tolerance + markerSize / 2.0;
+    double rx = reach / sx;
+    double ry = reach / sy;
+
+    m_hits.resize(0);
+    m_index.query(QRectF(point.x() - rx, point.y() - ry, 2 * rx, 2 * ry), &m_hits);
+
+    best = (double) tolerance * tolerance;
+    for (int i = 0; i < m_hits.size(); i++)
+    {
+        int slot = m_hits.at(i);
+        double d2 = distance2(slot, point, sx, sy);
+        if ((d2 < best) || ((d2 == best) && (slot > hit)))
+        {
+            best = d2;
+            hit = slot;
+        }
+    }
+
+    return (hit >= 0) ? handleOf(hit) : 0;
+}
+
+double VpDisplayList::distance2(int slot, const QPointF &point, double sx, double sy) const
+{
+    // Declare local variables.
+    const QPointF *p = m_points.constData() + m_first.at(slot);
+    int count = m_count.at(slot);
+    double best = 0;
+
+    // Work in device units relative to the point.
+    double px = point.x();
+    double py = point.y();
+
+    switch (m_types.at(slot))
+    {
+        case ITEM_LINE:
+        case ITEM_POLYLINE:
+            for (int i = 1; i < count; i++)
+            {
+                double d2 = segmentDistance2((p[i - 1].x() - px) * sx, (p[i - 1].y() - py) * sy,
+                                             (p[i].x() - px) * sx, (p[i].y() - py) * sy);
+                if ((i == 1) || (d2 < best))
+                    best = d2;
+            }
+            return best;
+        case ITEM_POLYGON:
+            if (pointInPolygon(px, py, p, count))
+                return 0;
+            for (int i = 0, j = count - 1; i < count; j = i++)
+            {
+                double d2 = segmentDistance2((p[j].x() - px) * sx, (p[j].y() - py) * sy,
+                                             (p[i].x() - px) * sx, (p[i].y() - py) * sy);
+                if ((i == 0) || (d2 < best))
+                    best = d2;
+            }
+            return best;
+        case ITEM_MARKER:
+        {
+            double h = m_styles.at(m_styleIds.at(slot)).m_markerSize / 2.0;
+            double dx = qMax(qAbs((p[0].x() - px) * sx) - h, 0.0);
+            double dy = qMax(qAbs((p[0].y() - py) * sy) - h, 0.0);
+            return dx * dx + dy * dy;
+        }
+        default:
+        {
+            // Rectangles are areas; text is its anchor.
+            double dx = qMax(qMax(m_xmin.at(slot) - px, px - m_xmax.at(slot)), 0.0) * sx;
+            double dy = qMax(qMax(m_ymin.at(slot) - py, py - m_ymax.at(slot)), 0.0) * sy;
+            return dx * dx + dy * dy;
+        }
+    }
+}
+
+void VpDisplayList::rebuildIndex()
+{
+    // Declare local variables.
+    QVector<VpSpatialIndex::Entry> entries;
+
+    entries.reserve(m_itemCount);
+    for (int slot = 0; slot < m_types.size(); slot++)
+    {
+        if (m_types.at(slot) == ITEM_NONE)
+            continue;
+        VpSpatialIndex::Entry entry = { m_xmin.at(slot), m_ymin.at(slot),
+                                        m_xmax.at(slot), m_ymax.at(slot), slot };
+        entries.append(entry);
+    }
+    m_index.load(entries);
+}
+
+void VpDisplayList::draw(QPainter *gc, const QTransform &matrix, const QRectF &clip)
+{
+    // Declare local variables.
+    double mx, my;
+
+    // Anchored items are sized in pixels, so widen the clip for them.
+    mx = (matrix.m11() != 0) ? qAbs(ANCHOR_MARGIN / matrix.m11()) : 0;
+    my = (matrix.m22() != 0) ? qAbs(ANCHOR_MARGIN / matrix.m22()) : 0;
+    QRectF wide = clip.adjusted(-mx, -my, mx, my);
+
+    // Query the index with the wider clip, then drop the geometry that
+    // only meets the margin.
+    m_visible.resize(0);
+    m_index.query(wide, &m_visible);
+    int count = 0;
+    for (int i = 0; i < m_visible.size(); i++)
+    {
+        int slot = m_visible.at(i);
+        int type = m_types.at(slot);
+        if ((type == ITEM_TEXT) || (type == ITEM_MARKER) ||
+            ((m_xmax.at(slot) >= clip.left()) && (m_xmin.at(slot) <= clip.right()) &&
+             (m_ymax.at(slot) >= clip.top()) && (m_ymin.at(slot) <= clip.bottom())))
+            m_visible[count++] = slot;
+    }
+    m_visible.resize(count);
+
+    // Keep the drawing order independent of the shape of the index.
+    std::sort(m_visible.begin(), m_visible.end());
+
+    drawSlots(gc, matrix, m_visible.constData(), m_visible.size());
+}
+
+void VpDisplayList::drawSlots(QPainter *gc, const QTransform &matrix,
+                              const int *visible, int count)
+{
+    // Declare local variables.
+    int current = -1;
+    bool world = true;
+
+    gc->setWorldTransform(matrix);
+    m_lines.resize(0);
+
+    for (int i = 0; i < count; i++)
+    {
+        int slot = visible[i];
+        int type = m_types.at(slot);
+        int style = m_styleIds.at(slot);
+        const QPointF *p = m_points.constData() + m_first.at(slot);
+
+        // Submit the pending lines before anything else changes.
+        if ((! m_lines.isEmpty()) && ((type != ITEM_LINE) || (style != current)))
+        {
+            if (! world)
+            {
+                gc->setWorldTransform(matrix);
+                world = true;
+            }
+            gc->drawLines(m_lines.constData(), m_lines.size());
+            m_lines.resize(0);
+        }
+
+        if (style != current)
+        {
+            const VpDisplayStyle &st = m_styles.at(style);
+            gc->setPen(st.m_pen);
+            gc->setBrush(st.m_brush);
+            gc->setFont(st.m_font);
+            current = style;
+        }
+
+        if ((type == ITEM_TEXT) || (type == ITEM_MARKER))
+        {
+            // Draw in device space at the mapped anchor.
+            QPointF d = matrix.map(p[0]);
+            if (world)
+            {
+                gc->resetTransform();
+                world = false;
+            }
+
+            if (type == ITEM_TEXT)
+                gc->drawText(d, m_texts.value(slot));
+            else
+            {
+                const VpDisplayStyle &st = m_styles.at(style);
+                qreal h = st.m_markerSize / 2.0;
+                switch (st.m_marker)
+                {
+                    case VpDisplayStyle::MARKER_CIRCLE:
+                        gc->drawEllipse(d, h, h);
+                        break;
+                    case VpDisplayStyle::MARKER_CROSS:
+                        gc->drawLine(QPointF(d.x() - h, d.y()), QPointF(d.x() + h, d.y()));
+                        gc->drawLine(QPointF(d.x(), d.y() - h), QPointF(d.x(), d.y() + h));
+                        break;
+                    default:
+                        gc->drawRect(QRectF(d.x() - h, d.y() - h, st.m_markerSize, st.m_markerSize));
+                        break;
+                }
+            }
+            continue;
+        }
+
+        if (type == ITEM_LINE)
+        {
+            m_lines.append(QLineF(p[0], p[1]));
+            continue;
+        }
+
+        if (! world)
+        {
+            gc->setWorldTransform(matrix);
+            world = true;
+        }
+        switch (type)
+        {
+            case ITEM_POLYLINE:
+                gc->drawPolyline(p, m_count.at(slot));
+                break;
+            case ITEM_RECT:
+                gc->drawRect(QRectF(p[0], p[1]).normalized());
+                break;
+            case ITEM_POLYGON:
+                gc->drawPolygon(p, m_count.at(slot));
+                break;
+        }
+    }
+
+    if (! m_lines.isEmpty())
+    {
+        if (! world)
+            gc->setWorldTransform(matrix);
+        gc->drawLines(m_lines.constData(), m_lines.size());
+        m_lines.resize(0);
+    }
+}
@@ -26,7 +26,7 @@
 #include "vpgc.h"
 
 VpGC::VpGC()
-    : m_viewport(NULL), m_gc(NULL)
+    : m_viewport(NULL), m_gc(NULL), m_deadline(NULL)
 {
     // Do nothing extra.
 }
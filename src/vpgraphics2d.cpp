@@ -28,19 +28,39 @@
 #include <QMouseEvent>
 #include <QResizeEvent>
 #include <QPaintEvent>
+#include <QTimerEvent>
+#include <QPixmap>
+#include <QImage>
+#include <QVector>
+#include <QTimer>
+#include <QTransform>
+#include <qmath.h>
 #include <QRubberBand>
+#include <QMetaMethod>
 #include <QDebug>
-#include <QMutex>
 
 // Include QtVp header files.
 #include "vptypes.h"
 #include "vputil.h"
+#include "vpkernels.h"
 #include "vpgraphics2d.h"
 #include "vpgc.h"
 #include "gridgc.h"
+#include "vpgridtilecache.h"
+#include "vpgridlayout.h"
+#include "vpdisplaylist.h"
+#include "vprenderthread.h"
+
+// Include system header files.
+#include <atomic>
+
+// The batched transforms hand QPoint arrays to the kernels as (x,y) int pairs.
+Q_STATIC_ASSERT(sizeof(QPoint) == 2 * sizeof(int));
 
 const int VpGraphics2D::MAX_WC_EXTENT = 0x7fffffff;
+const double VpGraphics2D::MIN_GRID_OPACITY = 0.2;
 const int VpGraphics2D::MIN_WC_EXTENT = -VpGraphics2D::MAX_WC_EXTENT;
+const double VpGraphics2D::MAX_WC_EXTENT_F = 9007199254740992.0;
 
 VpGraphics2D::VpGraphics2D(QWidget *parent)
   : VpViewport(parent)
@@ -56,9 +76,29 @@ VpGraphics2D::VpGraphics2D(QWidget *parent)
     m_2dYOffset = 0;
     m_2dPixelWidth = 0;
     m_2dPixelHeight = 0;
+    m_2dWxminF = 0;
+    m_2dWyminF = 0;
+    m_2dWxmaxF = 0;
+    m_2dWymaxF = 0;
+    m_2dXScaleF = 0;
+    m_2dYScaleF = 0;
+    m_2dXOffsetF = 0;
+    m_2dYOffsetF = 0;
+    m_2dXInvScale = 0;
+    m_2dYInvScale = 0;
     m_2dGrid = new VpGrid();
+    m_coordMode = COORD_INT;
+    m_gridTileCache = new VpGridTileCache();
+    m_displayList = new VpDisplayList(this);
 
     m_painter = new QPainter();
+    m_backingStoreValid = false;
+    m_transformVersion = 0;
+    m_gridTimeBudget = DEFAULT_GRID_TIME_BUDGET;
+    m_gridPending = false;
+    m_gridLayoutNext = 0;
+    m_renderMode = RENDER_DIRECT;
+    m_renderThread = NULL;
 
     // Enable mouse tracking.
     setMouseTracking(true);
@@ -66,15 +106,33 @@ VpGraphics2D::VpGraphics2D(QWidget *parent)
     // Initialize rubber-banding.
     m_rubberBand = 0;
     m_rubberBandIsShown = false;
+    m_selectionMode = SELECT_BY_DIRECTION;
+
+    // Allow points to be queued across threads.
+    qRegisterMetaType<VpPoint>("VpPoint");
+    qRegisterMetaType<VpRect>("VpRect");
+    qRegisterMetaType<VpTransform>("VpTransform");
+
+    // Initialize mouse move coalescing.
+    m_mousePending = false;
+    m_mouseButtons = Qt::NoButton;
+    m_mouseModifiers = Qt::NoModifier;
+    m_mouseMoveCoalesced = true;
+    m_coordValid = false;
+    m_coordX = 0;
+    m_coordY = 0;
 
     installEventFilter(this);
 
-    connect(this, SIGNAL(mouseMoved(const QMouseEvent &)), this, SLOT(processCoord(const QMouseEvent &)));
+    connect(m_displayList, SIGNAL(changed()), this, SLOT(invalidate()));
 }
 
 VpGraphics2D::~VpGraphics2D()
 {
+    // Stop the worker before anything it was given a snapshot of goes.
+    if (m_renderThread != NULL) delete m_renderThread;
     if (m_2dGrid != NULL) delete m_2dGrid;
+    if (m_gridTileCache != NULL) delete m_gridTileCache;
 }
 
 // Adjust the window extent such that it fits the viewport
@@ -151,19 +209,45 @@ bool VpGraphics2D::adjustExtentToViewport(
     tmpWymin = *Cc_ymin = *Wc_ymin;
     tmpWymax = *Cc_ymax = *Wc_ymax;
 
-    if ((*Wc_xmin < MIN_WC_EXTENT) || (*Wc_xmax > MAX_WC_EXTENT) ||
-        (*Wc_ymin < MIN_WC_EXTENT) || (*Wc_ymax > MAX_WC_EXTENT))
+    if (vp.getCoordMode() == COORD_DOUBLE)
     {
-        // Mapping causes integer overflow - unable to adjust extent.
-        //log4c("Unable to adjust extent.");
-        return false;
-    }
+        if (! ((*Wc_xmin >= -MAX_WC_EXTENT_F) && (*Wc_xmax <= MAX_WC_EXTENT_F) &&
+               (*Wc_ymin >= -MAX_WC_EXTENT_F) && (*Wc_ymax <= MAX_WC_EXTENT_F)))
+        {
+            // Mapping loses integer precision - unable to adjust extent.
+            return false;
+        }
+
+        // Save the exact world coordinates of VISIBLE viewport; the integer
+        // extent saturates.
+        vp.setWxminF(tmpWxmin);
+        vp.setWxmaxF(tmpWxmax);
+        vp.setWyminF(tmpWymin);
+        vp.setWymaxF(tmpWymax);
+        vp.setWxmin(saturate(tmpWxmin));
+        vp.setWxmax(saturate(tmpWxmax));
+        vp.setWymin(saturate(tmpWymin));
+        vp.setWymax(saturate(tmpWymax));
+    } else
+    {
+        if ((*Wc_xmin < MIN_WC_EXTENT) || (*Wc_xmax > MAX_WC_EXTENT) ||
+            (*Wc_ymin < MIN_WC_EXTENT) || (*Wc_ymax > MAX_WC_EXTENT))
+        {
+            // Mapping causes integer overflow - unable to adjust extent.
+            //log4c("Unable to adjust extent.");
+            return false;
+        }
 
-    // Save world coordinates of VISIBLE viewport.
-    vp.setWxmin(VpUtil::round(tmpWxmin));
-    vp.setWxmax(VpUtil::round(tmpWxmax));
-    vp.setWymin(VpUtil::round(tmpWymin));
-    vp.setWymax(VpUtil::round(tmpWymax));
+        // Save world coordinates of VISIBLE viewport.
+        vp.setWxmin(VpUtil::round(tmpWxmin));
+        vp.setWxmax(VpUtil::round(tmpWxmax));
+        vp.setWymin(VpUtil::round(tmpWymin));
+        vp.setWymax(VpUtil::round(tmpWymax));
+        vp.setWxminF(vp.getWxmin());
+        vp.setWxmaxF(vp.getWxmax());
+        vp.setWyminF(vp.getWymin());
+        vp.setWymaxF(vp.getWymax());
+    }
 
     // Calculate and save viewport offsets and scaling factors for general
     // bookkeeping of the viewport record structure - used in scaling
@@ -175,11 +259,24 @@ bool VpGraphics2D::adjustExtentToViewport(
     vp.setYScale((float)(-1 * yscale));
     vp.setXOffset((float)(Sxmin - *Wc_xmin * xscale));
     vp.setYOffset((float)(Symax - *Wc_ymin * (-1 * yscale)));
+    vp.setXScaleF(xscale);
+    vp.setYScaleF(-1 * yscale);
+    vp.setXOffsetF(Sxmin - *Wc_xmin * xscale);
+    vp.setYOffsetF(Symax - *Wc_ymin * (-1 * yscale));
+
+    // Derive the matrices from the new mapping and make it visible to
+    // other threads.
+    vp.publishTransform();
 
     return true;
 }
 
 bool VpGraphics2D::setWorldCoords(int xmin,int ymin,int xmax,int ymax)
+{
+    return setWorldCoords((double) xmin, (double) ymin, (double) xmax, (double) ymax);
+}
+
+bool VpGraphics2D::setWorldCoords(double xmin, double ymin, double xmax, double ymax)
 {
     // Declare local variables.
     double Wc_xmin,Wc_xmax,Wc_ymin,Wc_ymax;   // World coodinates.
@@ -222,37 +319,269 @@ bool VpGraphics2D::setWorldCoords(int xmin,int ymin,int xmax,int ymax)
     setPixelWidth(pixelwidth);
     setPixelHeight(pixelwidth);
 
+    // The cached rendering no longer matches the extent.
+    invalidate();
+
     return true;
 }
 
-void VpGraphics2D::worldToDev(int *x, int *y)
+bool VpGraphics2D::pan(int dx, int dy)
 {
     // Declare local variables.
-    int z = 0;
-    float fx, fy, fz;
+    double xscale, yscale, shiftx, shifty;
+    double wdx, wdy;
+    int sx, sy;
+
+    if ((getWxmax() == getWxmin()) || (getWymax() == getWymin()))
+        return false;
 
-    // Note that the result is int but the calculation is float.
-    fx = ((*x) * getXScale()) + getXOffset();
-    fy = ((*y) * getYScale()) + getYOffset();
+    // Scale of the mapping used to render the backing store.
+    QTransform render = getRenderTransform();
+    xscale = render.m11();
+    yscale = render.m22();
 
-    *x = VpUtil::round(fx);
-    *y = VpUtil::round(fy);
+    // The extent moves opposite to the content; by whole world units unless
+    // the extent is kept in double precision.
+    wdx = -dx / xscale;
+    wdy = -dy / yscale;
+    if (m_coordMode != COORD_DOUBLE)
+    {
+        wdx = (double) qRound64(wdx);
+        wdy = (double) qRound64(wdy);
+    }
+    if ((wdx == 0) && (wdy == 0))
+        return true;
+
+    if ((m_coordMode == COORD_DOUBLE) ?
+        ((getWxminF() + wdx < -MAX_WC_EXTENT_F) || (getWxmaxF() + wdx > MAX_WC_EXTENT_F) ||
+         (getWyminF() + wdy < -MAX_WC_EXTENT_F) || (getWymaxF() + wdy > MAX_WC_EXTENT_F)) :
+        ((getWxmin() + wdx < MIN_WC_EXTENT) || (getWxmax() + wdx > MAX_WC_EXTENT) ||
+         (getWymin() + wdy < MIN_WC_EXTENT) || (getWymax() + wdy > MAX_WC_EXTENT)))
+    {
+        // Mapping causes overflow - unable to adjust extent.
+        qDebug("Unable to adjust extent.");
+        return false;
+    }
+
+    // Shift the extent; the scale, and with it the pixel size, is unchanged.
+    setWxminF(getWxminF() + wdx);
+    setWxmaxF(getWxmaxF() + wdx);
+    setWyminF(getWyminF() + wdy);
+    setWymaxF(getWymaxF() + wdy);
+    setWxmin(saturate(getWxminF()));
+    setWxmax(saturate(getWxmaxF()));
+    setWymin(saturate(getWyminF()));
+    setWymax(saturate(getWymaxF()));
+    setXOffset((float) (getXOffset() - wdx * (double) getXScale()));
+    setYOffset((float) (getYOffset() - wdy * (double) getYScale()));
+    setXOffsetF(getXOffsetF() - wdx * getXScaleF());
+    setYOffsetF(getYOffsetF() - wdy * getYScaleF());
+    publishTransform();
+
+    // Reuse the rendered content if it moves by a whole number of pixels.
+    shiftx = -wdx * xscale;
+    shifty = -wdy * yscale;
+    sx = qRound(shiftx);
+    sy = qRound(shifty);
+    if (m_backingStoreValid && (m_renderMode == RENDER_DIRECT) &&
+        (qAbs(shiftx - sx) < 1e-6) && (qAbs(shifty - sy) < 1e-6) &&
+        (qAbs(sx) < width()) && (qAbs(sy) < height()))
+        scrollBackingStore(sx, sy);
+    else
+        invalidate();
+
+    return true;
+}
+
+void VpGraphics2D::publishTransform()
+{
+    VpTransform transform(m_2dWxmin, m_2dWymin, m_2dWxmax, m_2dWymax,
+        m_2dXScale, m_2dYScale, m_2dXOffset, m_2dYOffset, m_transformVersion + 1);
+    transform.setExtentF(m_2dWxminF, m_2dWyminF, m_2dWxmaxF, m_2dWymaxF);
+    transform.setMappingF(m_2dXScaleF, m_2dYScaleF, m_2dXOffsetF, m_2dYOffsetF);
+
+    // Cache the matrices and reciprocal scales for painting and picking,
+    // so that both use exactly the published mapping.
+    m_worldToDevMatrix = transform.getWorldToDevMatrix();
+    m_devToWorldMatrix = transform.getDevToWorldMatrix();
+    m_2dXInvScale = transform.getXInvScale();
+    m_2dYInvScale = transform.getYInvScale();
+
+    // Sequence lock. There is a single writer, the GUI thread, so the
+    // counter needs no read-modify-write ordering of its own: it is made
+    // odd, the release fence keeps the snapshot's stores after that, and
+    // the releasing increment publishes them.
+    m_transformSequence.fetchAndAddRelaxed(1);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_transform = transform;
+    ++m_transformVersion;
+    m_transformSequence.fetchAndAddRelease(1);
+
+    emit transformChanged(transform);
+}
+
+int VpGraphics2D::saturate(double value)
+{
+    if (value >= MAX_WC_EXTENT) return MAX_WC_EXTENT;
+    if (value <= MIN_WC_EXTENT) return MIN_WC_EXTENT;
+    return VpUtil::round(value);
+}
+
+QTransform VpGraphics2D::getRenderTransform()
+{
+    return m_worldToDevMatrix;
+}
+
+VpTransform VpGraphics2D::getTransform() const
+{
+    VpTransform transform;
+    int before, after;
+
+    // Retry until the snapshot was not written to while it was copied.
+    // The acquire fence keeps the copy's loads before the second read of
+    // the counter; a read-modify-write here would only contend with the
+    // writer's cache line.
+    do {
+        before = m_transformSequence.loadAcquire();
+        transform = m_transform;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_transformSequence.loadAcquire();
+    } while ((before & 1) || (before != after));
+
+    return transform;
+}
+
+void VpGraphics2D::worldToDev(int *x, int *y)
+{
+    // Declare local variables.
+    double fx = *x, fy = *y;
+
+    // Map through the matrix the view is painted with, so integer
+    // coordinates agree with what is drawn.
+    m_worldToDevMatrix.map(fx, fy, &fx, &fy);
+    if (m_coordMode == COORD_DOUBLE)
+    {
+        *x = saturate(fx);
+        *y = saturate(fy);
+    } else
+    {
+        *x = VpUtil::round(fx);
+        *y = VpUtil::round(fy);
+    }
 }
 
 void VpGraphics2D::devToWorld(int *x, int *y)
 {
     // Declare local variables.
-    float fx, fy, fz;
-    int z = 0;
+    double fx = *x, fy = *y;
+
+    // Map through the inverse of the painting matrix, as picking does.
+    m_devToWorldMatrix.map(fx, fy, &fx, &fy);
+    if (m_coordMode == COORD_DOUBLE)
+    {
+        *x = saturate(fx);
+        *y = saturate(fy);
+    } else
+    {
+        *x = VpUtil::round(fx);
+        *y = VpUtil::round(fy);
+    }
+}
+
+void VpGraphics2D::worldToDev(double *x, double *y)
+{
+    m_worldToDevMatrix.map(*x, *y, x, y);
+}
+
+void VpGraphics2D::devToWorld(double *x, double *y)
+{
+    m_devToWorldMatrix.map(*x, *y, x, y);
+}
+
+void VpGraphics2D::worldToDev(const QPoint *src, QPoint *dst, int count)
+{
+    if (m_coordMode == COORD_DOUBLE)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int x = src[i].x(), y = src[i].y();
+            worldToDev(&x, &y);
+            dst[i] = QPoint(x, y);
+        }
+        return;
+    }
+
+    // The kernels map with the matrix's own terms, reproducing
+    // worldToDev(int *, int *) exactly.
+    const QTransform &matrix = m_worldToDevMatrix;
+    VpKernels::worldToDev((const int *) src, (int *) dst, count,
+        matrix.m11(), matrix.m22(), matrix.dx(), matrix.dy());
+}
+
+void VpGraphics2D::worldToDev(const QPointF *src, QPointF *dst, int count)
+{
+    const QTransform &matrix = m_worldToDevMatrix;
 
-    fx = ((*x) - getXOffset()) / getXScale();
-    fy = ((*y) - getYOffset()) / getYScale();
+    for (int i = 0; i < count; i++)
+        dst[i] = matrix.map(src[i]);
+}
 
-    *x = VpUtil::round(fx);
-    *y = VpUtil::round(fy);
+void VpGraphics2D::devToWorld(const QPoint *src, QPoint *dst, int count)
+{
+    if (m_coordMode == COORD_DOUBLE)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int x = src[i].x(), y = src[i].y();
+            devToWorld(&x, &y);
+            dst[i] = QPoint(x, y);
+        }
+        return;
+    }
+
+    // The kernels map with the matrix's own terms, reproducing
+    // devToWorld(int *, int *) exactly.
+    const QTransform &matrix = m_devToWorldMatrix;
+    VpKernels::devToWorld((const int *) src, (int *) dst, count,
+        matrix.m11(), matrix.m22(), matrix.dx(), matrix.dy());
+}
+
+void VpGraphics2D::devToWorld(const QPointF *src, QPointF *dst, int count)
+{
+    const QTransform &matrix = m_devToWorldMatrix;
+
+    for (int i = 0; i < count; i++)
+        dst[i] = matrix.map(src[i]);
+}
+
+VpPoint VpGraphics2D::worldToDev(const VpPoint &point)
+{
+    VpPoint result = point;
+    worldToDev(&result.m_x, &result.m_y);
+    return result;
+}
+
+VpPoint VpGraphics2D::devToWorld(const VpPoint &point)
+{
+    VpPoint result = point;
+    devToWorld(&result.m_x, &result.m_y);
+    return result;
+}
+
+// VpPoint is laid out exactly like QPoint, so its arrays share the batches.
+Q_STATIC_ASSERT(sizeof(VpPoint) == sizeof(QPoint));
+
+void VpGraphics2D::worldToDev(const VpPoint *src, VpPoint *dst, int count)
+{
+    worldToDev((const QPoint *) src, (QPoint *) dst, count);
+}
+
+void VpGraphics2D::devToWorld(const VpPoint *src, VpPoint *dst, int count)
+{
+    devToWorld((const QPoint *) src, (QPoint *) dst, count);
 }
 
-QRect *VpGraphics2D::worldToDevRect(int xmin, int ymin, int xmax, int ymax)
+QRect VpGraphics2D::worldToDevRect(int xmin, int ymin, int xmax, int ymax)
 {
     // Declare local variables.
     int temp;
@@ -269,21 +598,19 @@ QRect *VpGraphics2D::worldToDevRect(int xmin, int ymin, int xmax, int ymax)
         temp = ymin; ymin = ymax; ymax = temp;
     }
 
-    QRect *rect = new QRect(xmin, ymin, xmax, ymax);
-
-    return rect;
+    return QRect(QPoint(xmin, ymin), QPoint(xmax, ymax));
 }
 
 void VpGraphics2D::scaleWorldToDev(int *x, int *y)
 {
-    *x = VpUtil::round((float)(*x) * getXScale());
-    *y = VpUtil::round((float)(*y) * getYScale());
+    *x = VpUtil::round((*x) * m_worldToDevMatrix.m11());
+    *y = VpUtil::round((*y) * m_worldToDevMatrix.m22());
 }
 
 void VpGraphics2D::scaleDevToWorld(int *x, int *y)
 {
-    *x = VpUtil::round((float)(*x) / getXScale());
-    *y = VpUtil::round((float)(*y) / getYScale());
+    *x = VpUtil::round((*x) * m_devToWorldMatrix.m11());
+    *y = VpUtil::round((*y) * m_devToWorldMatrix.m22());
 }
 
 bool VpGraphics2D::intersectWorld(VpGraphics2D &vp, int xll, int yll, int xur, int yur)
@@ -292,278 +619,344 @@ bool VpGraphics2D::intersectWorld(VpGraphics2D &vp, int xll, int yll, int xur, i
                yll > vp.getWymax() || yur < vp.getWymin()));
 }
 
+VpDisplayList::Handle VpGraphics2D::hitTest(const QPoint &pos, int tolerance)
+{
+    // Declare local variables.
+    double x = pos.x();
+    double y = pos.y();
+
+    devToWorld(&x, &y);
+    return m_displayList->pick(QPointF(x, y), tolerance, m_worldToDevMatrix);
+}
+
 // Grid drawing utilities.
 
 bool VpGraphics2D::drawGrid(VpGC *gc)
 {
     // Declare local variables.
-    int i, j, tmp, dx, dy;
-    int halfdx, halfdy, savx, savy;
+    GridLevel levels[2];
+    int count;
+
+    // Slow grids are not interrupted here; renderBackingStore() bounds the
+    // work done per frame by drawing the grid in strips against a time budget.
+    count = getGridLevels(*m_2dGrid, getPixelWidth(), getPixelHeight(), levels);
+    if (count == 0)
+        return false;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (! drawGridLevel(gc, levels[i].m_dx, levels[i].m_dy, levels[i].m_opacity))
+            return false;
+    }
+    return true;
+}
+
+bool VpGraphics2D::drawGrid(VpGrid &grid, VpGC *gc, const VpTransform &transform, CoordMode mode,
+                            double pw, double ph, VpGridLayout *layout)
+{
+    // Declare local variables.
+    GridLevel levels[2];
+    int count;
+    int wxmin, wymin, wxmax, wymax;
+
+    count = getGridLevels(grid, pw, ph, levels);
+    if (count == 0)
+        return false;
+    if (grid.getStyle() == VpGrid::STYLE_UNKNOWN)
+        return true;
+
+    getGridExtent(transform, mode, gc->getClipRect(), &wxmin, &wymin, &wxmax, &wymax);
+
+    for (int i = 0; i < count; i++)
+    {
+        layout->compute(wxmin, wymin, wxmax, wymax, levels[i].m_dx, levels[i].m_dy,
+                        grid.getXAlignment(), grid.getYAlignment(), grid.getStyle());
+        drawGridLayout(grid, gc, transform, mode, *layout, wxmin, wymin, wxmax, wymax,
+                       levels[i].m_dx, levels[i].m_dy, levels[i].m_opacity);
+    }
+
+    return true;
+}
+
+int VpGraphics2D::getGridLevels(VpGrid &grid, double pw, double ph, GridLevel *levels)
+{
+    // Declare local variables.
+    int dx, dy, base;
+    double opacity;
+
+    if (! getGridLevel(grid, pw, ph, &dx, &dy, &opacity))
+        return 0;
+
+    levels[0].m_dx = dx;
+    levels[0].m_dy = dy;
+    levels[0].m_opacity = 1.0;
+    if (opacity >= 1.0)
+        return 1;
+
+    // Draw the faded minor lines, then the major lines at full strength if
+    // they fit in the world extent.
+    levels[0].m_opacity = opacity;
+    base = getGridLevelBase(grid);
+    if (((qint64) dx * base > MAX_WC_EXTENT) || ((qint64) dy * base > MAX_WC_EXTENT))
+        return 1;
+    levels[1].m_dx = dx * base;
+    levels[1].m_dy = dy * base;
+    levels[1].m_opacity = 1.0;
+    return 2;
+}
+
+int VpGraphics2D::getGridLevelBase()
+{
+    return getGridLevelBase(*m_2dGrid);
+}
+
+int VpGraphics2D::getGridLevelBase(VpGrid &grid)
+{
+    return (grid.getMultiplier() > 1) ? grid.getMultiplier() : 2;
+}
+
+// Determine whether grid primitives spaced dx by dy world units apart are
+// far enough apart on the device to be drawn.
+static bool isSpacingResolvable(qint64 dx, qint64 dy, double pw, double ph, int xres, int yres)
+{
+    // Declare local variables.
     double pixdx, pixdy;
-    int xll, yll, xur, yur;
-    int truexll, trueyll, truexur, trueyur;
-    bool status;
-    int count=0, xnum=0, ynum=0;
-    GridGC *gridGC = new GridGC();
 
-    // Set return point status for interrupts.
-    /*
-    status = AS_SET_RETURN_POINT();
-    if (status != 0)
+    pixdx = (pw != 0) ? (double) dx / pw : 0;
+    pixdy = (ph != 0) ? (double) dy / ph : 0;
+
+    return (((dx >> 1) >= pw) && ((dy >> 1) >= ph) &&
+            (pixdx >= xres) && (pixdy >= yres));
+}
+
+bool VpGraphics2D::getGridLevel(int *dx, int *dy, double *opacity)
+{
+    return getGridLevel(*m_2dGrid, getPixelWidth(), getPixelHeight(), dx, dy, opacity);
+}
+
+bool VpGraphics2D::getGridLevel(VpGrid &grid, double pw, double ph, int *dx, int *dy, double *opacity)
+{
+    // Declare local variables.
+    qint64 sx, sy;
+    double minx, miny, ratio, t;
+    int base, level, xres, yres;
+
+    sx = (qint64) grid.getXSpacing() * grid.getMultiplier();
+    sy = (qint64) grid.getYSpacing() * grid.getMultiplier();
+    if ((sx <= 0) || (sy <= 0) || (sx > MAX_WC_EXTENT) || (sy > MAX_WC_EXTENT))
+        return false;
+
+    xres = grid.getXResolution();
+    yres = grid.getYResolution();
+    *opacity = 1.0;
+
+    if (! grid.isAdaptive())
     {
-        // Interrupted! Abort grid display.
+        // The grid is drawn at its own spacing or not at all.
+        *dx = (int) sx;
+        *dy = (int) sy;
+        return isSpacingResolvable(sx, sy, pw, ph, xres, yres);
+    }
 
-        // Restore x and y spacing parameters - flush display.
-        m_2dGrid.setXSpacing(savx);
-        m_2dGrid.setYSpacing(savy);
+    // The finest spacing the device resolution allows, in world units.
+    base = getGridLevelBase(grid);
+    minx = qMax(2.0 * pw, xres * pw);
+    miny = qMax(2.0 * ph, yres * ph);
 
-        // Clear return points and interrupt handling.
-        AS_restore_sig();
-        AS_CLEAR_RETURN_POINT();
-        return(true);
-        // XXX - Should probably return more information here in the future.
+    // Estimate the number of subdivisions to drop from the ratio of the
+    // two spacings, then correct the estimate for rounding.
+    ratio = qMax(minx / sx, miny / sy);
+    level = (ratio > 1.0) ? (int) qCeil(qLn(ratio) / qLn((double) base)) : 0;
+    for (int i = 0; (i < level) && (sx <= MAX_WC_EXTENT) && (sy <= MAX_WC_EXTENT); i++)
+    {
+        sx *= base;
+        sy *= base;
+    }
+    while ((sx <= MAX_WC_EXTENT) && (sy <= MAX_WC_EXTENT) &&
+           ! isSpacingResolvable(sx, sy, pw, ph, xres, yres))
+    {
+        sx *= base;
+        sy *= base;
+    }
+    if ((sx > MAX_WC_EXTENT) || (sy > MAX_WC_EXTENT))
+        return false;
+
+    // Fade the level in as it opens up from the resolution limit to the
+    // point where the next finer level takes over.
+    if ((minx > 0) && (miny > 0))
+    {
+        t = qMin(qLn(sx / minx), qLn(sy / miny)) / qLn((double) base);
+        t = qBound(0.0, t, 1.0);
+        *opacity = MIN_GRID_OPACITY + (1.0 - MIN_GRID_OPACITY) * t;
     }
-    */
 
-    // Save spacing and use display spacing to snap boundaries.
+    *dx = (int) sx;
+    *dy = (int) sy;
+    return true;
+}
 
-    // The following two lines must occur before enabling the interrupt.
-    // This guarantees that we have valid spacing values to restore to
-    // the grid record strructure upon interrupting the display and
-    // returning to the calling command (i.e. grid or window).  See
-    // above return point!
-    savx = m_2dGrid->getXSpacing();
-    savy = m_2dGrid->getYSpacing();
+bool VpGraphics2D::drawGridLevel(VpGC *gc, int dx, int dy, double opacity)
+{
+    // Declare local variables.
+    int wxmin, wymin, wxmax, wymax;
 
-    // Initialize interrupt handling routine.
-    //AS_trap_to(VP_handle_grid_break);
-
-    dx = m_2dGrid->getXSpacing() * m_2dGrid->getMultiplier();
-    dy = m_2dGrid->getYSpacing() * m_2dGrid->getMultiplier();
-    halfdx = dx >> 1;
-    halfdy = dy >> 1;
-    if (getPixelWidth() != 0)
-        pixdx = (double) dx / getPixelWidth();
-    else
-        pixdx = 0;
-    if (getPixelHeight() != 0)
-        pixdy = (double) dy / getPixelHeight();
-    else
-        pixdy = 0;
+    if (m_2dGrid->getStyle() == VpGrid::STYLE_UNKNOWN)
+        return true;
 
-    if (((halfdx >= getPixelWidth()) && (halfdy >= getPixelHeight())) &&
-        ((pixdx >= m_2dGrid->getXResolution()) &&
-         (pixdy >= m_2dGrid->getYResolution())))
+    // Determine the world extent to cover. The GUI thread publishes the
+    // mapping, so it reads it without the sequence lock.
+    getGridExtent(m_transform, m_coordMode, gc->getClipRect(), &wxmin, &wymin, &wxmax, &wymax);
+
+    // Snap the extent to the display spacing, so that primitives stay in
+    // phase with the grid alignment whatever extent is covered, and count
+    // the grid primitives.
+    const VpGridLayout &layout = getGridLayout(wxmin, wymin, wxmax, wymax, dx, dy);
+
+    drawGridLayout(*m_2dGrid, gc, m_transform, m_coordMode, layout, wxmin, wymin, wxmax, wymax, dx, dy, opacity);
+
+    return true;
+}
+
+// Convert a device coordinate to world coordinate as devToWorld(int *, int *)
+// does in the specified coordinate mode.
+static void gridDevToWorld(const VpTransform &transform, VpGraphics2D::CoordMode mode, int *x, int *y)
+{
+    if (mode == VpGraphics2D::COORD_DOUBLE)
     {
-        switch (m_2dGrid->getStyle())
-        {
-            case VpGrid::STYLE_LINE:
-
-                xll = getWxmin() - halfdx;
-                yll = getWymin() - halfdy;
-                xur = getWxmax() + halfdx;
-                yur = getWymax() + halfdy;
-
-                // Snap to new temporary spacing values stored
-                // in the grid object.
-                m_2dGrid->snapToGrid(&xll, &yll);
-                m_2dGrid->snapToGrid(&xur, &yur);
-
-                // Calculate the number of grid primitives.
-                for (i = xll; i <= xur; i = i + dx )
-                    xnum++;
-                for (j = yll; j <= yur; j = j + dy )
-                    ynum++;
-
-                // Get true dc values (non-snapped) for clipping
-                // against vp extent.
-                truexll = getWxmin();
-                trueyll = getWymin();
-                truexur = getWxmax();
-                trueyur = getWymax();
-                worldToDev(&truexll, &trueyll);
-                worldToDev(&truexur, &trueyur);
-                if (truexur < truexll) {
-                    tmp = truexll;
-                    truexll = truexur;
-                    truexur = tmp;
-                }
-                if (trueyur < trueyll) {
-                    tmp = trueyll;
-                    trueyll = trueyur;
-                    trueyur = tmp;
-                }
+        double dx = *x, dy = *y;
+        transform.devToWorld(&dx, &dy);
+        *x = VpGraphics2D::saturate(dx);
+        *y = VpGraphics2D::saturate(dy);
+    } else
+        transform.devToWorld(x, y);
+}
 
-                // Fill-out grid extent data.
-                gridGC->m_gc = gc;
-                gridGC->m_xll = xll;
-                gridGC->m_yll = yll;
-                gridGC->m_xur = xur;
-                gridGC->m_yur = yur;
-                gridGC->m_truexll = truexll;
-                gridGC->m_trueyll = trueyll;
-                gridGC->m_truexur = truexur;
-                gridGC->m_trueyur = trueyur;
-                gridGC->m_xnum = xnum;
-                gridGC->m_ynum = ynum;
-                gridGC->m_dx = dx;
-                gridGC->m_dy = dy;
-
-                // Draw the dot grid.
-                m_2dGrid->draw(*gridGC);
-                break;
-
-            case VpGrid::STYLE_DOT:
-
-                m_2dGrid->setXSpacing(dx);
-                m_2dGrid->setYSpacing(dy);
-                xll = getWxmin() + halfdx;
-                yll = getWymin() + halfdy;
-                xur = getWxmax() - halfdx;
-                yur = getWymax() - halfdy;
-
-                // Snap to new temporary spacing values stored
-                // in the grid object.
-                m_2dGrid->snapToGrid(&xll, &yll);
-                m_2dGrid->snapToGrid(&xur, &yur);
-
-                // Calculate the number of grid primitives.
-                for (i = xll; i <= xur; i = i + dx )
-                    xnum++;
-                for (j = yll; j <= yur; j = j + dy )
-                    ynum++;
-
-                // Get true dc values (non-snapped) for clipping
-                // against vp extent.
-                truexll = getWxmin();
-                trueyll = getWymin();
-                truexur = getWxmax();
-                trueyur = getWymax();
-                worldToDev(&truexll, &trueyll);
-                worldToDev(&truexur, &trueyur);
-                if (truexur < truexll) {
-                    tmp = truexll;
-                    truexll = truexur;
-                    truexur = tmp;
-                }
-                if (trueyur < trueyll) {
-                    tmp = trueyll;
-                    trueyll = trueyur;
-                    trueyur = tmp;
-                }
+// Convert a world coordinate to device coordinate as worldToDev(int *, int *)
+// does in the specified coordinate mode.
+static void gridWorldToDev(const VpTransform &transform, VpGraphics2D::CoordMode mode, int *x, int *y)
+{
+    if (mode == VpGraphics2D::COORD_DOUBLE)
+    {
+        double dx = *x, dy = *y;
+        transform.worldToDev(&dx, &dy);
+        *x = VpGraphics2D::saturate(dx);
+        *y = VpGraphics2D::saturate(dy);
+    } else
+        transform.worldToDev(x, y);
+}
 
-                // Fill-out grid extent data.
-                gridGC->m_gc = gc;
-                gridGC->m_xll = xll;
-                gridGC->m_yll = yll;
-                gridGC->m_xur = xur;
-                gridGC->m_yur = yur;
-                gridGC->m_truexll = truexll;
-                gridGC->m_trueyll = trueyll;
-                gridGC->m_truexur = truexur;
-                gridGC->m_trueyur = trueyur;
-                gridGC->m_xnum = xnum;
-                gridGC->m_ynum = ynum - 1;
-                gridGC->m_dx = dx;
-                gridGC->m_dy = dy;
-
-                // Draw the dot grid.
-                m_2dGrid->draw(*gridGC);
-                break;
-
-            case VpGrid::STYLE_CROSS:
-
-                xll = getWxmin() - halfdx;
-                yll = getWymin() - halfdy;
-                xur = getWxmax() + halfdx;
-                yur = getWymax() + halfdy;
-
-
-                // Snap to new temporary spacing values stored
-                // in the grid object.
-                m_2dGrid->snapToGrid(&xll, &yll);
-                m_2dGrid->snapToGrid(&xur, &yur);
-
-                // Calculate the number of grid primitives.
-                for (i = xll; i <= xur; i = i + dx )
-                    xnum++;
-                for (j = yll; j <= yur; j = j + dy )
-                    ynum++;
-
-                // Get true dc values (non-snapped) for clipping
-                // against vp extent.
-                truexll = getWxmin();
-                trueyll = getWymin();
-                truexur = getWxmax();
-                trueyur = getWymax();
-                worldToDev(&truexll, &trueyll);
-                worldToDev(&truexur, &trueyur);
-                if (truexur < truexll) {
-                    tmp = truexll;
-                    truexll = truexur;
-                    truexur = tmp;
-                }
-                if (trueyur < trueyll) {
-                    tmp = trueyll;
-                    trueyll = trueyur;
-                    trueyur = tmp;
-                }
+void VpGraphics2D::getGridExtent(const VpTransform &transform, CoordMode mode, const QRect &clip,
+                                 int *wxmin, int *wymin, int *wxmax, int *wymax)
+{
+    // Declare local variables.
+    int tmp;
 
-                // Fill-out grid extent data.
-                gridGC->m_gc = gc;
-                gridGC->m_xll = xll;
-                gridGC->m_yll = yll;
-                gridGC->m_xur = xur;
-                gridGC->m_yur = yur;
-                gridGC->m_truexll = truexll;
-                gridGC->m_trueyll = trueyll;
-                gridGC->m_truexur = truexur;
-                gridGC->m_trueyur = trueyur;
-                gridGC->m_xnum = xnum - 1;
-                gridGC->m_ynum = ynum - 1;
-                gridGC->m_dx = dx;
-                gridGC->m_dy = dy;
-
-                // Draw the cross grid.
-                m_2dGrid->draw(*gridGC);
-                break;
-
-            case VpGrid::STYLE_UNKNOWN:
-                break;
-
-        } // switch
-
-        // Restore x and y spacing parameter.
-        m_2dGrid->setXSpacing(savx);
-        m_2dGrid->setYSpacing(savy);
-
-        // Clear return points and interrupt handling.
-        //AS_CLEAR_RETURN_POINT();
-        //AS_restore_sig();
-
-        status = true;
+    // If the graphics context restricts drawing to a device rectangle, only
+    // cover that rectangle (padded by a pixel so primitives straddling its
+    // edges are drawn).
+    if (clip.isNull())
+    {
+        *wxmin = transform.getWxmin();
+        *wymin = transform.getWymin();
+        *wxmax = transform.getWxmax();
+        *wymax = transform.getWymax();
     } else
     {
-        // Restore x and y spacing parameters.
-        m_2dGrid->setXSpacing(savx);
-        m_2dGrid->setYSpacing(savy);
+        *wxmin = clip.left() - 1;
+        *wymin = clip.bottom() + 1;
+        *wxmax = clip.right() + 1;
+        *wymax = clip.top() - 1;
+        gridDevToWorld(transform, mode, wxmin, wymin);
+        gridDevToWorld(transform, mode, wxmax, wymax);
+        if (*wxmax < *wxmin) {
+            tmp = *wxmin;
+            *wxmin = *wxmax;
+            *wxmax = tmp;
+        }
+        if (*wymax < *wymin) {
+            tmp = *wymin;
+            *wymin = *wymax;
+            *wymax = tmp;
+        }
+    }
+}
 
-        // Clear return points and interrupt handling.
-        //AS_CLEAR_RETURN_POINT();
-        //AS_restore_sig();
+void VpGraphics2D::drawGridLayout(VpGrid &grid, VpGC *gc, const VpTransform &transform,
+                                  CoordMode mode, const VpGridLayout &layout,
+                                  int wxmin, int wymin, int wxmax, int wymax,
+                                  int dx, int dy, double opacity)
+{
+    // Declare local variables.
+    int tmp;
+    int truexll, trueyll, truexur, trueyur;
+    GridGC gridGC;
+
+    // Get true dc values (non-snapped) for clipping against vp extent.
+    truexll = wxmin;
+    trueyll = wymin;
+    truexur = wxmax;
+    trueyur = wymax;
+    gridWorldToDev(transform, mode, &truexll, &trueyll);
+    gridWorldToDev(transform, mode, &truexur, &trueyur);
+    if (truexur < truexll) {
+        tmp = truexll;
+        truexll = truexur;
+        truexur = tmp;
+    }
+    if (trueyur < trueyll) {
+        tmp = trueyll;
+        trueyll = trueyur;
+        trueyur = tmp;
+    }
+
+    // Fill-out grid extent data.
+    gridGC.m_gc = gc;
+    gridGC.m_xll = layout.getXll();
+    gridGC.m_yll = layout.getYll();
+    gridGC.m_xur = layout.getXur();
+    gridGC.m_yur = layout.getYur();
+    gridGC.m_truexll = truexll;
+    gridGC.m_trueyll = trueyll;
+    gridGC.m_truexur = truexur;
+    gridGC.m_trueyur = trueyur;
+    gridGC.m_xnum = layout.getXnum();
+    gridGC.m_ynum = layout.getYnum();
+    gridGC.m_dx = dx;
+    gridGC.m_dy = dy;
+    gridGC.m_opacity = opacity;
+    gridGC.m_deadline = gc->getDeadline();
+
+    // Draw the grid in its style.
+    grid.draw(gridGC);
+}
+
+const VpGridLayout &VpGraphics2D::getGridLayout(int wxmin, int wymin, int wxmax, int wymax,
+                                                int dx, int dy)
+{
+    // Declare local variables.
+    int xalignment = m_2dGrid->getXAlignment();
+    int yalignment = m_2dGrid->getYAlignment();
+    VpGrid::Style style = m_2dGrid->getStyle();
 
-        status = false;
+    // Major and minor levels are drawn alternately, so keep one of each.
+    for (int i = 0; i < GRID_LAYOUT_CACHE_SIZE; i++)
+    {
+        if (m_gridLayouts[i].isLayoutOf(wxmin, wymin, wxmax, wymax,
+                                        dx, dy, xalignment, yalignment, style))
+            return m_gridLayouts[i];
     }
 
-    delete gridGC;
-    return status;
+    VpGridLayout &layout = m_gridLayouts[m_gridLayoutNext];
+    m_gridLayoutNext = (m_gridLayoutNext + 1) % GRID_LAYOUT_CACHE_SIZE;
+    layout.compute(wxmin, wymin, wxmax, wymax, dx, dy, xalignment, yalignment, style);
+    return layout;
 }
 
 bool VpGraphics2D::drawGridReference(VpGC *gc)
 {
     // Declare local variables.
     int status = true;
-    GridGC *gridGC = new GridGC();
+    GridGC gridGC;
 
     // Set return point status for interrupts.
     /*
@@ -582,19 +975,146 @@ bool VpGraphics2D::drawGridReference(VpGC *gc)
     */
 
     // Fill-out grid extent data.
-    gridGC->m_gc = gc;
+    gridGC.m_gc = gc;
 
     // Draw the dot grid.
-    m_2dGrid->drawReference(*gridGC);
+    m_2dGrid->drawReference(gridGC);
 
     // Clear return points and interrupt handling.
     //AS_CLEAR_RETURN_POINT();
     //AS_restore_sig();
 
-    delete gridGC;
     return status;
 }
 
+bool VpGraphics2D::drawGridTiles(VpGC *gc)
+{
+    // Declare local variables.
+    const int size = VpGridTileCache::TILE_SIZE;
+    QPainter *painter = gc->getGC();
+    QTransform render = getRenderTransform();
+    qreal ratio = devicePixelRatio();
+    VpDeadline *deadline = gc->getDeadline();
+    double originx, originy;
+    int tx, ty, tx0, ty0, tx1, ty1, left, top;
+    int rendered = 0;
+
+    // Tiles are anchored at the device position of the world origin, so
+    // that a pan by whole pixels keeps hitting the same tiles and only the
+    // sub-pixel phase of the origin distinguishes them. The phase is
+    // quantised, so that it does not make every key unique.
+    originx = floor(render.dx());
+    originy = floor(render.dy());
+
+    VpGridTileKey key;
+    key.m_xscale = render.m11();
+    key.m_yscale = render.m22();
+    key.m_xphase = qRound((render.dx() - originx) * VpGridTileCache::PHASE_STEPS) /
+        (double) VpGridTileCache::PHASE_STEPS;
+    key.m_yphase = qRound((render.dy() - originy) * VpGridTileCache::PHASE_STEPS) /
+        (double) VpGridTileCache::PHASE_STEPS;
+    key.m_ratio = ratio;
+    key.setGrid(*m_2dGrid);
+
+    // Determine the tiles covering the area to draw.
+    QRect area = gc->getClipRect();
+    if (area.isNull())
+        area = rect();
+    tx0 = (int) floor((area.left() - originx) / size);
+    ty0 = (int) floor((area.top() - originy) / size);
+    tx1 = (int) floor((area.right() - originx) / size);
+    ty1 = (int) floor((area.bottom() - originy) / size);
+
+    // Tiles are rendered at the quantised phase, so a cached tile matches
+    // any frame with the same key.
+    QTransform tileRender(key.m_xscale, 0, 0, key.m_yscale,
+        originx + key.m_xphase, originy + key.m_yphase);
+
+    // Tiles are composited in device coordinates.
+    painter->save();
+    painter->resetTransform();
+
+    for (ty = ty0; ty <= ty1; ty++)
+    {
+        for (tx = tx0; tx <= tx1; tx++)
+        {
+            left = (int) (originx + (double) tx * size);
+            top = (int) (originy + (double) ty * size);
+            key.m_tx = tx;
+            key.m_ty = ty;
+
+            QPixmap *tile = m_gridTileCache->find(key);
+            if (tile != NULL)
+            {
+                painter->drawPixmap(left, top, *tile);
+                continue;
+            }
+
+            // Stop between missing tiles once the frame's budget is spent,
+            // even in a strip drawn without a deadline; rendering one tile
+            // per call still makes progress, as finished tiles are cached.
+            if ((rendered > 0) && m_gridDeadline.hasExpired())
+            {
+                painter->restore();
+                return true;
+            }
+
+            // Render the missing tile.
+            tile = new QPixmap(QSize(size, size) * ratio);
+            tile->setDevicePixelRatio(ratio);
+            tile->fill(Qt::transparent);
+
+            QPainter tilePainter(tile);
+            tilePainter.setWorldTransform(tileRender * QTransform::fromTranslate(-left, -top));
+            VpGC tileGC;
+            tileGC.setViewport(this);
+            tileGC.setGC(&tilePainter);
+            tileGC.setClipRect(QRect(left, top, size, size));
+            tileGC.setDeadline(deadline);
+            bool status = drawGrid(&tileGC);
+            tilePainter.end();
+
+            if ((deadline != NULL) && deadline->isStopped())
+            {
+                // An interrupted tile is incomplete; don't cache it. The
+                // caller draws the strip again in a later frame.
+                delete tile;
+                painter->restore();
+                return true;
+            }
+
+            if (! status)
+            {
+                // The grid is too fine; no tile can be drawn.
+                delete tile;
+                painter->restore();
+                return false;
+            }
+
+            painter->drawPixmap(left, top, *tile);
+            m_gridTileCache->insert(key, tile);
+            rendered++;
+        }
+    }
+
+    painter->restore();
+    return true;
+}
+
+void VpGraphics2D::setGridTileCacheBudget(int budget)
+{
+    if (budget <= 0)
+    {
+        if (m_gridTileCache != NULL) delete m_gridTileCache;
+        m_gridTileCache = NULL;
+    } else if (m_gridTileCache == NULL)
+        m_gridTileCache = new VpGridTileCache(budget);
+    else
+        m_gridTileCache->setBudget(budget);
+
+    invalidate();
+}
+
 bool VpGraphics2D::displayGrid(VpGC *gc)
 {
     // Declare local variables.
@@ -602,7 +1122,8 @@ bool VpGraphics2D::displayGrid(VpGC *gc)
 
     if (m_2dGrid->getState() == VpGrid::STATE_ON)
     {
-        if (drawGrid(gc) == false)
+        bool drawn = (m_gridTileCache != NULL) ? drawGridTiles(gc) : drawGrid(gc);
+        if (drawn == false)
         {
             QString msg(getName());
             msg.append(tr(" : grid is too fine to be displayed."));
@@ -704,7 +1225,7 @@ void VpGraphics2D::updateGrid(VpGC *gc, const GridState &dispState)
     } else
          multiplier = m_2dGrid->getMultiplier();
 
-    VpCoord alignment = dispState.m_alignment;
+    const VpCoord &alignment = dispState.m_alignment;
     if ((alignment.getX() != m_2dGrid->getXAlignment()) ||
         (alignment.getY() != m_2dGrid->getYAlignment()))
     {
@@ -738,6 +1259,7 @@ void VpGraphics2D::updateGrid(VpGC *gc, const GridState &dispState)
         m_2dGrid->setYResolution(VpGrid::getGridYResolution());
 
         displayGrid(gc);
+        invalidate();
     }
 }
 
@@ -783,6 +1305,7 @@ void VpGraphics2D::updateGridReference(VpGC *gc, const GridState &dispState)
             (m_2dGrid->getState() == VpGrid::STATE_HIDDEN))
             // Always draw the reference, even if the grid is hidden.
             drawGridReference(gc);
+        invalidate();
     }
 }
 
@@ -791,6 +1314,23 @@ void VpGraphics2D::snapToGrid(int *x, int *y)
     m_2dGrid->snapToGrid(x, y);
 }
 
+void VpGraphics2D::snapToGrid(const QPoint *src, QPoint *dst, int count)
+{
+    m_2dGrid->snapToGrid(src, dst, count);
+}
+
+void VpGraphics2D::snapToGrid(double *x, double *y)
+{
+    m_2dGrid->snapToGrid(x, y);
+}
+
+VpPoint VpGraphics2D::snapToGrid(const VpPoint &point)
+{
+    VpPoint result = point;
+    snapToGrid(&result.m_x, &result.m_y);
+    return result;
+}
+
 QString VpGraphics2D::toString()
 {
     // Declare local variables.
@@ -856,15 +1396,12 @@ void VpGraphics2D::clear()
     m_painter->end();
 }
 
-QMutex mutex;
-
 void VpGraphics2D::resizeEvent(QResizeEvent *event)
 {
     int x_min, y_min, x_max, y_max;
     //int Sx_min, Sy_min, Sx_max, Sy_max;
 
     //qDebug("VpGraphics2D: Resize event.");
-    QMutexLocker locker(&mutex);
 
     //Sx_min = getPxmin();
     //Sx_max = getPxmax();
@@ -895,57 +1432,359 @@ void VpGraphics2D::resizeEvent(QResizeEvent *event)
     {
         // Set existing world coordinate extent to new
         // resized, physical coordinat extent.
-        x_min = getWxmin();
-        x_max = getWxmax();
-        y_min = getWymin();
-        y_max = getWymax();
-        setWorldCoords(x_min, y_min, x_max, y_max);
+        if (m_coordMode == COORD_DOUBLE)
+            setWorldCoords(getWxminF(), getWyminF(), getWxmaxF(), getWymaxF());
+        else
+        {
+            x_min = getWxmin();
+            x_max = getWxmax();
+            y_min = getWymin();
+            y_max = getWymax();
+            setWorldCoords(x_min, y_min, x_max, y_max);
+        }
     }
     qDebug() << "VpGraphics2d Physical: (" << getPxmin() << "," << getPymin() << ") - (" << getPxmax() << "," << getPymax() << ")";
     qDebug() << "VpGraphics2d World: (" << getWxmin() << "," << getWymin() << ") - (" << getWxmax() << "," << getWymax() << ")";
 }
 
-void VpGraphics2D::paintEvent(QPaintEvent *event)
+void VpGraphics2D::invalidate()
 {
-    //qDebug("VpGraphics2D: Paint event.");
-    QMutexLocker locker(&mutex);
+    m_backingStoreValid = false;
+    update();
+}
 
-    // Clear the viewport.
-    clear();
+void VpGraphics2D::renderBackingStore(const QRegion &region)
+{
+    // Declare local variables.
+    QRegion area(region);
+    QRegion remaining;
+
+    m_gridDeadline.start(m_gridTimeBudget);
+
+    if (area.isEmpty())
+    {
+        // Size the backing store to the widget in device pixels.
+        qreal ratio = devicePixelRatio();
+        QSize pixelSize = size() * ratio;
+        if (m_backingStore.size() != pixelSize)
+            m_backingStore = QPixmap(pixelSize);
+        m_backingStore.setDevicePixelRatio(ratio);
+        area = QRegion(rect());
+
+        // Clear the backing store using the current background.
+        m_backingStore.fill(palette().color(backgroundRole()));
+    }
 
     // Create the Qt graphics context.
     QPainter *gc = m_painter;
-    gc->begin(this);
+    gc->begin(&m_backingStore);
 
-    // Set world coordinate extent.
-    QRect extent;
-    extent.setLeft(getWxmin());
-    extent.setRight(getWxmax());
-    extent.setTop(getWymax());
-    extent.setBottom(getWymin());
-    m_painter->setWindow(extent);
+    // Map the world coordinate extent onto the widget.
+    QTransform render = getRenderTransform();
+    gc->setWorldTransform(render);
 
     // Set up the viewport context.
     VpGC vpgc;
     vpgc.setViewport(this);
     vpgc.setGC(gc);
 
-    // Erase the previous grid.
-    //eraseGrid(vpgc);
-
-    // Display the grid.
-    //m_vp.getGrid().setColor(new AuColor(0, 0, 255));
-    if (displayGrid(&vpgc))
+    if (m_gridTimeBudget <= 0)
     {
-        /*
-        QString msg(getName());
-        msg.append(tr(": grid displayed successfully."));
-        emit updateStatus(msg);
-        */
+        // No budget; display the grid over the whole area in one go.
+        if (region.isEmpty())
+        {
+            displayGrid(&vpgc);
+            drawDisplayList(gc, rect());
+        } else
+        {
+            // Clear just the region being regenerated.
+            gc->resetTransform();
+            gc->setClipRegion(area);
+            gc->fillRect(rect(), palette().brush(backgroundRole()));
+            gc->setWorldTransform(render);
+
+            for (QRegion::const_iterator it = area.begin(); it != area.end(); ++it)
+            {
+                vpgc.setClipRect(*it);
+                displayGrid(&vpgc);
+                drawDisplayList(gc, *it);
+            }
+        }
+    } else
+    {
+        if (region.isEmpty())
+        {
+            // Show a coarse grid at once. Its primitives are a subset of the
+            // full grid's, so the strips below only need to add detail.
+            drawCoarseGrid(&vpgc);
+        }
+
+        // Refine the grid one strip at a time until the frame's budget is
+        // spent. The first strip is drawn without a deadline so every frame
+        // makes progress (with tiles, it stops after the first missing tile
+        // once the budget is spent); the others stop at the row or tile
+        // where the budget runs out.
+        int drawn = 0;
+        for (QRegion::const_iterator it = area.begin(); it != area.end(); ++it)
+        {
+            const QRect &r = *it;
+            for (int y = r.top(); y <= r.bottom(); y += GRID_STRIP_HEIGHT)
+            {
+                QRect strip(r.left(), y, r.width(), qMin(GRID_STRIP_HEIGHT, r.bottom() - y + 1));
+                if ((! remaining.isEmpty()) ||
+                    ((drawn > 0) && m_gridDeadline.hasExpired()))
+                {
+                    remaining += strip;
+                    continue;
+                }
+
+                // Clear the strip, then draw the full grid clipped to it.
+                gc->save();
+                gc->resetTransform();
+                gc->setClipRect(strip);
+                gc->fillRect(strip, palette().brush(backgroundRole()));
+                gc->setWorldTransform(render);
+                vpgc.setClipRect(strip);
+                vpgc.setDeadline((drawn > 0) ? &m_gridDeadline : NULL);
+                displayGrid(&vpgc);
+                if (! m_gridDeadline.isStopped())
+                    drawDisplayList(gc, strip);
+                gc->restore();
+
+                // An interrupted strip is drawn again in a later frame.
+                if (m_gridDeadline.isStopped())
+                    remaining += strip;
+                else
+                    drawn++;
+            }
+        }
     }
 
     // Complete painting.
     gc->end();
+
+    m_backingStoreValid = true;
+    m_backingStoreDirty = remaining;
+
+    if (remaining.isEmpty())
+    {
+        m_gridPending = false;
+        emit gridComplete();
+    } else if (! m_gridPending)
+    {
+        // Resume in a later frame, once pending input has been handled.
+        m_gridPending = true;
+        QTimer::singleShot(0, this, SLOT(continueGrid()));
+    }
+}
+
+void VpGraphics2D::drawDisplayList(QPainter *gc, const QRect &area)
+{
+    if (m_displayList->getCount() == 0)
+        return;
+
+    // Draw only the items within the world rectangle under the area.
+    QRectF clip = m_devToWorldMatrix.mapRect(QRectF(area));
+    gc->save();
+    gc->resetTransform();
+    gc->setClipRect(area, Qt::IntersectClip);
+    m_displayList->draw(gc, m_worldToDevMatrix, clip);
+    gc->restore();
+}
+
+void VpGraphics2D::continueGrid()
+{
+    m_gridPending = false;
+    if (m_backingStoreValid && (! m_backingStoreDirty.isEmpty()))
+        update(m_backingStoreDirty.boundingRect());
+}
+
+void VpGraphics2D::cancelGrid()
+{
+    // Whatever has been drawn so far stays; the rest is abandoned until
+    // the view is next invalidated.
+    m_gridDeadline.cancel();
+    m_backingStoreDirty = QRegion();
+    m_gridPending = false;
+}
+
+void VpGraphics2D::setGridTimeBudget(int budget)
+{
+    m_gridTimeBudget = (budget > 0) ? budget : 0;
+}
+
+void VpGraphics2D::drawCoarseGrid(VpGC *gc)
+{
+    // Declare local variables.
+    GridLevel levels[2];
+    int count;
+    int wxmin, wymin, wxmax, wymax;
+    qint64 cx, cy;
+    VpGridLayout layout;
+
+    if ((m_2dGrid->getState() != VpGrid::STATE_ON) ||
+        (m_2dGrid->getStyle() == VpGrid::STYLE_UNKNOWN))
+        return;
+    count = getGridLevels(*m_2dGrid, getPixelWidth(), getPixelHeight(), levels);
+    if (count == 0)
+        return;
+
+    // Coarsen the last level drawn; a faded level below it is not part of
+    // the final grid at full strength.
+    cx = (qint64) levels[count - 1].m_dx * COARSE_GRID_FACTOR;
+    cy = (qint64) levels[count - 1].m_dy * COARSE_GRID_FACTOR;
+    if ((cx > MAX_WC_EXTENT) || (cy > MAX_WC_EXTENT))
+        return;
+
+    // Lay the preview out privately so the cached layouts of the full grid
+    // are kept.
+    getGridExtent(m_transform, m_coordMode, gc->getClipRect(), &wxmin, &wymin, &wxmax, &wymax);
+    layout.compute(wxmin, wymin, wxmax, wymax, (int) cx, (int) cy,
+                   m_2dGrid->getXAlignment(), m_2dGrid->getYAlignment(), m_2dGrid->getStyle());
+    drawGridLayout(*m_2dGrid, gc, m_transform, m_coordMode, layout,
+                   wxmin, wymin, wxmax, wymax, (int) cx, (int) cy, 1.0);
+}
+
+void VpGraphics2D::scrollBackingStore(int dx, int dy)
+{
+    qreal ratio = m_backingStore.devicePixelRatio();
+    m_backingStore.scroll(qRound(dx * ratio), qRound(dy * ratio), m_backingStore.rect());
+
+    // Pending work moves with the content; the uncovered strips are new work.
+    QRegion exposed = QRegion(rect()) - QRegion(rect().translated(dx, dy));
+    m_backingStoreDirty.translate(dx, dy);
+    m_backingStoreDirty = (m_backingStoreDirty & QRegion(rect())) | exposed;
+
+    // Scroll the widget without moving its children (the rubber-band).
+    scroll(dx, dy, rect());
+}
+
+void VpGraphics2D::paintEvent(QPaintEvent *event)
+{
+    //qDebug("VpGraphics2D: Paint event.");
+
+    if (m_renderMode == RENDER_THREADED)
+    {
+        paintFrame(event);
+        return;
+    }
+
+    // Regenerate the backing store only if the view has changed since it
+    // was last rendered.
+    if ((! m_backingStoreValid) ||
+        (m_backingStore.devicePixelRatio() != devicePixelRatio()) ||
+        (m_backingStore.size() != size() * devicePixelRatio()))
+        renderBackingStore();
+    else if (! m_backingStoreDirty.isEmpty())
+        renderBackingStore(m_backingStoreDirty);
+
+    // Copy the damaged region from the backing store.
+    qreal ratio = m_backingStore.devicePixelRatio();
+    QPainter *gc = m_painter;
+    gc->begin(this);
+    // Iterate the region in place; building a list of its rectangles
+    // would allocate on every paint.
+    const QRegion &region = event->region();
+    for (QRegion::const_iterator it = region.begin(); it != region.end(); ++it)
+        copyBackingStore(gc, *it, ratio);
+    gc->end();
+}
+
+void VpGraphics2D::copyBackingStore(QPainter *gc, const QRect &r, qreal ratio)
+{
+    QRect source(QPoint(qRound(r.x() * ratio), qRound(r.y() * ratio)), r.size() * ratio);
+    gc->drawPixmap(r, m_backingStore, source);
+}
+
+void VpGraphics2D::setRenderMode(RenderMode mode)
+{
+    if (m_renderMode == mode)
+        return;
+
+    m_renderMode = mode;
+    if (mode == RENDER_THREADED)
+    {
+        m_renderThread = new VpRenderThread();
+        connect(m_renderThread, SIGNAL(frameReady()), this, SLOT(presentFrame()));
+    } else
+    {
+        // The destructor waits for the worker to finish.
+        delete m_renderThread;
+        m_renderThread = NULL;
+        m_frame = QImage();
+        m_frameRequestSize = QSize();
+    }
+
+    invalidate();
+}
+
+void VpGraphics2D::requestFrame()
+{
+    qreal ratio = devicePixelRatio();
+
+    // The GUI thread publishes the mapping, so it reads it without the
+    // sequence lock.
+    m_renderThread->request(m_transform, m_coordMode, getPixelWidth(), getPixelHeight(),
+                            size(), ratio, palette().color(backgroundRole()),
+                            *m_2dGrid, *m_displayList);
+    m_frameRequestSize = size() * ratio;
+
+    // The backing store stands for the requested frame.
+    m_backingStoreValid = true;
+}
+
+void VpGraphics2D::paintFrame(QPaintEvent *event)
+{
+    // Ask for a new frame only if the view has changed since the last request.
+    if ((! m_backingStoreValid) || (m_frameRequestSize != size() * devicePixelRatio()))
+        requestFrame();
+
+    QPainter *gc = m_painter;
+    gc->begin(this);
+    if (m_frame.isNull())
+    {
+        // Nothing has been rendered yet.
+        gc->fillRect(event->rect(), palette().brush(backgroundRole()));
+    } else if (m_frameTransform.getVersion() == m_transform.getVersion())
+    {
+        // The frame shows the current mapping; copy the damaged region.
+        qreal ratio = m_frame.devicePixelRatio();
+        const QRegion &region = event->region();
+        for (QRegion::const_iterator it = region.begin(); it != region.end(); ++it)
+            copyFrame(gc, *it, ratio);
+    } else
+    {
+        // Show the frame mapped to the current mapping until the frame
+        // for it arrives.
+        gc->fillRect(event->rect(), palette().brush(backgroundRole()));
+        gc->setTransform(m_frameTransform.getDevToWorldMatrix() * m_worldToDevMatrix);
+        gc->drawImage(QPointF(0, 0), m_frame);
+    }
+    gc->end();
+}
+
+void VpGraphics2D::copyFrame(QPainter *gc, const QRect &r, qreal ratio)
+{
+    QRect source(QPoint(qRound(r.x() * ratio), qRound(r.y() * ratio)), r.size() * ratio);
+    gc->drawImage(r, m_frame, source);
+}
+
+void VpGraphics2D::presentFrame()
+{
+    bool gridDrawn;
+
+    if ((m_renderThread == NULL) ||
+        (! m_renderThread->getFrame(&m_frame, &m_frameTransform, &gridDrawn)))
+        return;
+    update();
+
+    if (! gridDrawn)
+    {
+        QString msg(getName());
+        msg.append(tr(" : grid is too fine to be displayed."));
+        emit updateStatus(msg);
+    } else
+        emit gridComplete();
 }
 
 bool VpGraphics2D::eventFilter(QObject *obj, QEvent *ev)
@@ -954,8 +1793,7 @@ bool VpGraphics2D::eventFilter(QObject *obj, QEvent *ev)
     {
         if (ev->type() == QEvent::Leave)
         {
-            QString msg("");
-            emit updateStatus(msg);
+            emit updateStatus(QString());
             return true;
         } else {
             return false;
@@ -970,6 +1808,9 @@ void VpGraphics2D::mousePressEvent(QMouseEvent *event)
 {
     int scrx, scry;
 
+    // Deliver any pending move first, so events stay in order.
+    processMouseMove();
+
     //qDebug("VpGraphics2D: Mouse press event.");
 
     // Get device coordinate from event.
@@ -995,6 +1836,7 @@ void VpGraphics2D::mousePressEvent(QMouseEvent *event)
         pos.setX(scrx);
         pos.setY(scry);
         m_rubberBandOrigin = pos;
+        m_rubberBandOriginF = devToSnappedWorld(event->pos());
         if (! m_rubberBand)
             // Create rubber-band if necessary.
             m_rubberBand = new QRubberBand(QRubberBand::Rectangle, this);
@@ -1015,12 +1857,30 @@ void VpGraphics2D::mousePressEvent(QMouseEvent *event)
 
 void VpGraphics2D::mouseReleaseEvent(QMouseEvent *event)
 {
+    // Deliver any pending move first, so events stay in order.
+    processMouseMove();
+
     if (m_rubberBandIsShown)
     {
         m_rubberBand->hide();
 
-        // Determine selection, for example using QRect::intersects()
-        // and QRect::contains().
+        // Select the display list items under the band. Its corners are
+        // snapped in world coordinates, as the origin was when pressed.
+        QPointF corner = devToSnappedWorld(event->pos());
+        bool contained;
+        if (m_selectionMode == SELECT_BY_DIRECTION)
+            contained = (event->x() >= m_rubberBandOrigin.x());
+        else
+            contained = (m_selectionMode == SELECT_CONTAINS);
+
+        // Keep the last selection, to tell whether this one changes it.
+        m_selection.swap(m_lastSelection);
+        m_selection.resize(0);
+        m_displayList->select(QRectF(m_rubberBandOriginF, corner), contained, &m_selection);
+
+        // A click that leaves the selection as it was selects nothing new.
+        if ((corner != m_rubberBandOriginF) || (m_selection != m_lastSelection))
+            emit itemsSelected(m_selection);
 
         m_rubberBandIsShown = false;
 
@@ -1035,23 +1895,83 @@ void VpGraphics2D::mouseReleaseEvent(QMouseEvent *event)
     event->accept();
 }
 
+QPointF VpGraphics2D::devToSnappedWorld(const QPoint &pos)
+{
+    // Declare local variables.
+    double x = pos.x();
+    double y = pos.y();
+
+    devToWorld(&x, &y);
+    if (m_2dGrid->getState() != VpGrid::STATE_OFF)
+        snapToGrid(&x, &y);
+
+    return QPointF(x, y);
+}
+
 void VpGraphics2D::mouseMoveEvent(QMouseEvent *event)
 {
-   int scrx, scry;
+    // Keep only the latest position; it is processed at most once per
+    // frame, however fast the device reports.
+    m_mousePos = event->localPos();
+    m_mouseWindowPos = event->windowPos();
+    m_mouseScreenPos = event->screenPos();
+    m_mouseButtons = event->buttons();
+    m_mouseModifiers = event->modifiers();
+    m_mousePending = true;
+
+    if (! m_mouseMoveCoalesced)
+        processMouseMove();
+    else if (! m_mouseTimer.isActive())
+    {
+        // The first move after a pause is processed at once; the moves
+        // following it wait for the next frame. Keeping the timer running
+        // while moves arrive means it is not registered again per move.
+        processMouseMove();
+        m_mouseTimer.start(MOUSE_MOVE_INTERVAL, Qt::PreciseTimer, this);
+    }
 
-    // Get device coordinate from event.
-    scrx = event->x();
-    scry = event->y();
+    // Make sure events don't propagate to the parent.
+    event->accept();
+}
 
-    if (m_2dGrid->getState() != VpGrid::STATE_OFF)
+void VpGraphics2D::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != m_mouseTimer.timerId())
     {
-        // Translate device coodinate into world coordinate.
-        devToWorld(&scrx, &scry);
+        VpViewport::timerEvent(event);
+        return;
+    }
+
+    // Stop once a frame has passed without a move.
+    if (m_mousePending)
+        processMouseMove();
+    else
+        m_mouseTimer.stop();
+}
+
+void VpGraphics2D::processMouseMove()
+{
+    int wx, wy, scrx, scry;
+
+    if (! m_mousePending)
+        return;
+    m_mousePending = false;
+
+    // Get device coordinate from the latest event.
+    scrx = wx = qRound(m_mousePos.x());
+    scry = wy = qRound(m_mousePos.y());
+
+    // Translate device coodinate into world coordinate, once.
+    devToWorld(&wx, &wy);
 
+    if (m_2dGrid->getState() != VpGrid::STATE_OFF)
+    {
         // Snap to the nearest grid coordinate.
-        snapToGrid(&scrx, &scry);
+        snapToGrid(&wx, &wy);
 
         // Translate world coordinate back into device coordinate.
+        scrx = wx;
+        scry = wy;
         worldToDev(&scrx, &scry);
     }
 
@@ -1061,11 +1981,30 @@ void VpGraphics2D::mouseMoveEvent(QMouseEvent *event)
     if (m_rubberBandIsShown)
         m_rubberBand->setGeometry(QRect(m_rubberBandOrigin, pos).normalized());
 
-    // Send the signal by forwarding the event.
-    emit mouseMoved(*event);
+    // Send the signals with the latest position. Only build an event for
+    // mouseMoved() if someone listens for it.
+    emit mouseMovedTo(m_mousePos, m_mouseButtons, m_mouseModifiers);
+    static const QMetaMethod movedSignal = QMetaMethod::fromSignal(&VpGraphics2D::mouseMoved);
+    if (isSignalConnected(movedSignal))
+    {
+        QMouseEvent event(QEvent::MouseMove, m_mousePos, m_mouseWindowPos, m_mouseScreenPos,
+                          Qt::NoButton, m_mouseButtons, m_mouseModifiers);
+        emit mouseMoved(event);
+    }
 
-    // Make sure events don't propagate to the parent.
-    event->accept();
+    updateCoord(wx, wy);
+}
+
+void VpGraphics2D::setMouseMoveCoalesced(bool coalesced)
+{
+    m_mouseMoveCoalesced = coalesced;
+
+    // Don't leave a move waiting on a frame that may not come.
+    if (! coalesced)
+    {
+        m_mouseTimer.stop();
+        processMouseMove();
+    }
 }
 
 void VpGraphics2D::processCoord(const QMouseEvent &event)
@@ -1084,10 +2023,26 @@ void VpGraphics2D::processCoord(const QMouseEvent &event)
     if (m_2dGrid->getState() != VpGrid::STATE_OFF)
         snapToGrid(&scrx, &scry);
 
-    VpCoord coord;
-    coord.setX(scrx);
-    coord.setY(scry);
-    coord.setName(m_name);
+    updateCoord(scrx, scry);
+}
 
-    emit coordChanged(coord);
+void VpGraphics2D::updateCoord(int x, int y)
+{
+    // Only a change of coordinate is worth a signal.
+    if (m_coordValid && (x == m_coordX) && (y == m_coordY))
+        return;
+    m_coordValid = true;
+    m_coordX = x;
+    m_coordY = y;
+
+    VpPoint point(x, y);
+    emit pointChanged(point);
+
+    // Only build the named coordinate if someone listens for it.
+    static const QMetaMethod coordSignal = QMetaMethod::fromSignal(&VpGraphics2D::coordChanged);
+    if (isSignalConnected(coordSignal))
+    {
+        VpCoord coord(point, m_name);
+        emit coordChanged(coord);
+    }
 }
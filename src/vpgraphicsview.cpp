@@ -23,17 +23,28 @@
 
 // Include Qt header files.
 #include <QGridLayout>
+#include <QEvent>
 
 // Include QtVp header files.
 #include "vpgraphicsview.h"
 
 VpGraphicsView::VpGraphicsView(QWidget *parent)
-  :  QScrollArea(parent)
+  :  QScrollArea(parent),
+     m_transformPending(false),
+     m_extentPending(false),
+     m_extentIsF(false),
+     m_content(NULL),
+     m_horizontalRuler(NULL),
+     m_verticalRuler(NULL)
 {
+    m_propagateTimer.setSingleShot(true);
+    m_propagateTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_propagateTimer, SIGNAL(timeout()), this, SLOT(propagate()));
 }
 
 VpGraphicsView::~VpGraphicsView()
 {
+    if (m_window != NULL) m_window->removeEventFilter(this);
     if (m_horizontalRuler != NULL) delete m_horizontalRuler;
     if (m_verticalRuler != NULL) delete m_verticalRuler;
 }
@@ -62,15 +73,47 @@ void VpGraphicsView::init(QWidget *widget)
     gridLayout->addWidget(widget, 1, 1);
 
     setLayout(gridLayout);
+
+    // The rulers share the content viewport's mapping rather than derive
+    // their own from its extent.
+    watchWindow();
+    m_content = qobject_cast<VpGraphics2D *>(widget);
+    if (m_content != NULL)
+    {
+        connect(m_content, SIGNAL(transformChanged(VpTransform)),
+                this, SLOT(on_newTransform(VpTransform)));
+        VpTransform transform = m_content->getTransform();
+        if (transform.getVersion() > 0)
+            on_newTransform(transform);
+    }
 }
 
 void VpGraphicsView::on_newExtent(QRect size, QPoint origin)
 {
-    qDebug("VpGraphicsView: Received new extent.");
-    m_horizontalRuler->setExtent(size, origin);
-    m_verticalRuler->setExtent(size, origin);
-    m_horizontalRuler->update();
-    m_verticalRuler->update();
+    // The rulers already follow the content viewport's mapping.
+    if (m_content != NULL)
+        return;
+
+    // Only the latest extent matters.
+    m_pendingExtent = size;
+    m_pendingOrigin = origin;
+    m_extentIsF = false;
+    m_extentPending = true;
+    schedulePropagation();
+}
+
+void VpGraphicsView::on_newExtent(QRectF size, QPointF origin)
+{
+    // The rulers already follow the content viewport's mapping.
+    if (m_content != NULL)
+        return;
+
+    // Only the latest extent matters.
+    m_pendingExtentF = size;
+    m_pendingOriginF = origin;
+    m_extentIsF = true;
+    m_extentPending = true;
+    schedulePropagation();
 }
 
 void VpGraphicsView::on_trackExtent(bool track)
@@ -78,3 +121,86 @@ void VpGraphicsView::on_trackExtent(bool track)
     m_horizontalRuler->setExtentTrack(track);
     m_verticalRuler->setExtentTrack(track);
 }
+
+void VpGraphicsView::on_newTransform(const VpTransform &transform)
+{
+    // Only the latest mapping matters.
+    m_pendingTransform = transform;
+    m_transformPending = true;
+    schedulePropagation();
+}
+
+void VpGraphicsView::schedulePropagation()
+{
+    if (m_propagateTimer.isActive())
+        return;
+
+    // The content has scheduled its repaint; propagating when the window
+    // is about to repaint lets the rulers be painted in the same frame.
+    // The timer covers a change that does not repaint the window.
+    m_propagateTimer.start(FRAME_INTERVAL);
+}
+
+void VpGraphicsView::watchWindow()
+{
+    QWidget *current = window();
+    if (m_window == current)
+        return;
+
+    if (m_window != NULL) m_window->removeEventFilter(this);
+    m_window = current;
+    m_window->installEventFilter(this);
+}
+
+void VpGraphicsView::propagate()
+{
+    m_propagateTimer.stop();
+
+    if (m_transformPending)
+    {
+        m_transformPending = false;
+        m_horizontalRuler->setTransform(m_pendingTransform);
+        m_verticalRuler->setTransform(m_pendingTransform);
+    }
+
+    if (m_extentPending)
+    {
+        m_extentPending = false;
+        if (m_extentIsF)
+        {
+            m_horizontalRuler->setExtent(m_pendingExtentF, m_pendingOriginF);
+            m_verticalRuler->setExtent(m_pendingExtentF, m_pendingOriginF);
+        } else
+        {
+            m_horizontalRuler->setExtent(m_pendingExtent, m_pendingOrigin);
+            m_verticalRuler->setExtent(m_pendingExtent, m_pendingOrigin);
+        }
+        m_horizontalRuler->update();
+        m_verticalRuler->update();
+    }
+}
+
+bool VpGraphicsView::eventFilter(QObject *obj, QEvent *ev)
+{
+    // The window is about to repaint; ruler updates made now are painted
+    // along with the content.
+    if ((ev->type() == QEvent::UpdateRequest) && (obj == m_window) &&
+        (m_transformPending || m_extentPending))
+        propagate();
+
+    // The window has itself been placed in another window.
+    if ((ev->type() == QEvent::ParentChange) && (obj == m_window))
+        watchWindow();
+
+    // Pass the event on to the parent class.
+    return QScrollArea::eventFilter(obj, ev);
+}
+
+bool VpGraphicsView::event(QEvent *ev)
+{
+    if (ev->type() == QEvent::ParentChange)
+        watchWindow();
+
+    // Pass the event on to the parent class.
+    return QScrollArea::event(ev);
+}
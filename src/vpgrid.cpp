@@ -24,12 +24,17 @@
 // Include Qt header files.
 #include <QPainter>
 #include <QPoint>
+#include <QImage>
+#include <QTransform>
+#include <qmath.h>
 
 // Include QtVp heaeder files.
 #include "vputil.h"
+#include "vpkernels.h"
 #include "vpgrid.h"
 #include "vpgc.h"
 #include "vpgraphics2d.h"
+#include "vpdeadline.h"
 #include "gridgc.h"
 
 /*   The variable g_gridXResolution is an integer which the user may set to   */
@@ -71,17 +76,38 @@ bool VpGrid::init()
     setYAlignment(0);
     setXResolution(1);
     setYResolution(1);
+    setAdaptive(true);
     setReferenceState(VpGrid::REFSTATE_OFF);
     setReferenceStyle(VpGrid::REFSTYLE_SQUARE);
     m_referenceColor.setRed(0);
     m_referenceColor.setGreen(0);
     m_referenceColor.setBlue(0);
     m_referenceColor.setAlpha(255);
+    setRasterStamping(true);
 
     status = true;
     return status;
 }
 
+void VpGrid::copy(VpGrid &grid)
+{
+    setState(grid.getState());
+    setStyle(grid.getStyle());
+    setColor(grid.getColor());
+    setXSpacing(grid.getXSpacing());
+    setYSpacing(grid.getYSpacing());
+    setMultiplier(grid.getMultiplier());
+    setXAlignment(grid.getXAlignment());
+    setYAlignment(grid.getYAlignment());
+    setXResolution(grid.getXResolution());
+    setYResolution(grid.getYResolution());
+    setAdaptive(grid.isAdaptive());
+    setReferenceState(grid.getReferenceState());
+    setReferenceStyle(grid.getReferenceStyle());
+    setReferenceColor(grid.getReferenceColor());
+    setRasterStamping(grid.isRasterStamping());
+}
+
 bool VpGrid::snapToGrid(int *x, int *y)
 {
     // Declare local variables.
@@ -104,6 +130,44 @@ bool VpGrid::snapToGrid(int *x, int *y)
     return status;
 }
 
+bool VpGrid::snapToGrid(double *x, double *y)
+{
+    // Declare local variables.
+    double qx, qy;
+
+    if (getState() != STATE_OFF)
+    {
+        // Snap without dead band, rounding half away from zero.
+        qx = (*x - getXAlignment()) / (double) getXSpacing();
+        qy = (*y - getYAlignment()) / (double) getYSpacing();
+        qx = (qx < 0.0) ? ceil(qx - 0.5) : floor(qx + 0.5);
+        qy = (qy < 0.0) ? ceil(qy - 0.5) : floor(qy + 0.5);
+        *x = qx * getXSpacing() + getXAlignment();
+        *y = qy * getYSpacing() + getYAlignment();
+    }
+
+    return true;
+}
+
+bool VpGrid::snapToGrid(const QPoint *src, QPoint *dst, int count)
+{
+    bool status = false;
+
+    if (getState() != STATE_OFF)
+    {
+        // Snap without dead band.
+        VpKernels::snapToGrid((const int *) src, (int *) dst, count,
+            getXSpacing(), getYSpacing(), getXAlignment(), getYAlignment());
+    } else if (dst != src)
+    {
+        for (int i = 0; i < count; i++)
+            dst[i] = src[i];
+    }
+
+    status = true;
+    return status;
+}
+
 bool VpGrid::getGridCoord(int *x, int *y)
 {
     bool status = false;
@@ -124,9 +188,18 @@ bool VpGrid::isReferenceOn()
         return false;
 }
 
+// Determine whether drawing must stop, polling the context's deadline.
+static inline bool isExpired(GridGC &gridGC)
+{
+    return (gridGC.m_deadline != NULL) && gridGC.m_deadline->hasExpired();
+}
+
 void VpGrid::draw(GridGC &gridGC)
 {
     // Set up the display characteristics.
+    QPainter *gc = gridGC.m_gc->getGC();
+    qreal opacity = gc->opacity();
+    gc->setOpacity(opacity * gridGC.m_opacity);
 
     // Draw the grid pattern.
     switch(m_style) {
@@ -143,6 +216,8 @@ void VpGrid::draw(GridGC &gridGC)
             drawLineGrid(gridGC);
             break;
     }
+
+    gc->setOpacity(opacity);
 }
 
 void VpGrid::drawLineGrid(GridGC &gridGC)
@@ -154,32 +229,38 @@ void VpGrid::drawLineGrid(GridGC &gridGC)
     // Assuming QPainter has already established begin().
     gc->setRenderHint(QPainter::Antialiasing, true);
 
-    // Set the pen.
-    QPen pen;
-    pen.setColor(m_color);
-    pen.setStyle(Qt::SolidLine);
-    gc->setPen(pen);
-    // Set the brush.
-    QBrush brush;
-    brush.setColor(m_color);
-    brush.setStyle(Qt::SolidPattern);
-    gc->setBrush(brush);
-
-    // Draw the grid.
+    // Set the pen and the brush.
+    updatePens();
+    gc->setPen(m_gridPen);
+    gc->setBrush(m_gridBrush);
+
+    // Collect all the lines and draw them with a single call.
+    int count = qMax(gridGC.m_xnum - 1, 0) + qMax(gridGC.m_ynum - 1, 0);
+    if (m_lines.size() < count)
+        m_lines.resize(count);
+    QLine *lines = m_lines.data();
+    int n = 0;
+
+    // The layout keeps every position within the int range, but the offset
+    // from the lower bound may exceed it, so positions are summed in 64 bits.
     for (int i = 1; i < gridGC.m_xnum; i++)
     {
-        x = gridGC.m_xll + (i * gridGC.m_dx);
-        y = gridGC.m_yll;
-        gc->drawLine(x, gridGC.m_yll, x, gridGC.m_yur);
+        if (isExpired(gridGC))
+            return;
+        x = (int) (gridGC.m_xll + ((qint64) i * gridGC.m_dx));
+        lines[n++].setLine(x, gridGC.m_yll, x, gridGC.m_yur);
     }
 
     for (int j = 1; j < gridGC.m_ynum; j++)
     {
-        x = gridGC.m_xll;
-        y = gridGC.m_yll + (j * gridGC.m_dy);
-        gc->drawLine(gridGC.m_xll, y, gridGC.m_xur, y);
+        if (isExpired(gridGC))
+            return;
+        y = (int) (gridGC.m_yll + ((qint64) j * gridGC.m_dy));
+        lines[n++].setLine(gridGC.m_xll, y, gridGC.m_xur, y);
     }
 
+    gc->drawLines(lines, n);
+
     // Flush graphics to display.
     //gc.flush();
 
@@ -196,19 +277,34 @@ void VpGrid::drawDotGrid(GridGC &gridGC)
     gc->setRenderHint(QPainter::Antialiasing, true);
 
     // Set the pen.
-    QPen pen;
-    pen.setColor(m_color);
-    pen.setStyle(Qt::SolidLine);
-    gc->setPen(pen);
+    updatePens();
+    gc->setPen(m_gridPen);
+
+    // Prefer stamping rows of dots.
+    if (m_rasterStamping && drawStampedGrid(gridGC, false))
+        return;
+
+    // Collect all the dots and draw them with a single call.
+    int count = qMax(gridGC.m_ynum + 1, 0) * qMax(gridGC.m_xnum, 0);
+    if (m_points.size() < count)
+        m_points.resize(count);
+    QPoint *points = m_points.data();
+    int n = 0;
 
     for (int i = 0; i < gridGC.m_ynum + 1; i++) {
-        y = gridGC.m_yll + (i * gridGC.m_dy);
+        if (isExpired(gridGC))
+            return;
+        y = (int) (gridGC.m_yll + ((qint64) i * gridGC.m_dy));
         for (int j = 0; j < gridGC.m_xnum; j++) {
-            x = gridGC.m_xll + (j * gridGC.m_dx);
-            gc->drawPoint(x, y);
+            x = (int) (gridGC.m_xll + ((qint64) j * gridGC.m_dx));
+            points[n].setX(x);
+            points[n].setY(y);
+            n++;
         }
     }
 
+    gc->drawPoints(points, n);
+
     // Flush graphics to display.
     //gc.flush();
 
@@ -225,24 +321,33 @@ void VpGrid::drawCrossGrid(GridGC &gridGC)
     gc->setRenderHint(QPainter::Antialiasing, true);
 
     // Set the pen.
-    QPen pen;
-    pen.setColor(m_color);
-    pen.setStyle(Qt::SolidLine);
-    gc->setPen(pen);
+    updatePens();
+    gc->setPen(m_gridPen);
 
-    // Create a cross Marker.
-    QLine cross[2];
+    // Prefer stamping rows of crosses.
+    if (m_rasterStamping && drawStampedGrid(gridGC, true))
+        return;
+
+    // Collect both strokes of every cross and draw them with a single call.
+    int count = 2 * qMax(gridGC.m_ynum + 1, 0) * qMax(gridGC.m_xnum, 0);
+    if (m_lines.size() < count)
+        m_lines.resize(count);
+    QLine *lines = m_lines.data();
+    int n = 0;
 
     for (int i = 0; i < gridGC.m_ynum + 1; i++) {
-        y = gridGC.m_yll + (i * gridGC.m_dy);
+        if (isExpired(gridGC))
+            return;
+        y = (int) (gridGC.m_yll + ((qint64) i * gridGC.m_dy));
         for (int j = 0; j < gridGC.m_xnum; j++) {
-            x = gridGC.m_xll + (j * gridGC.m_dx);
-            cross[0].setLine(x-1, y, x+1, y);
-            cross[1].setLine(x, y-1, x, y+1);
-            gc->drawLines(cross, 2);
+            x = (int) (gridGC.m_xll + ((qint64) j * gridGC.m_dx));
+            lines[n++].setLine(x-1, y, x+1, y);
+            lines[n++].setLine(x, y-1, x, y+1);
         }
     }
 
+    gc->drawLines(lines, n);
+
     // Flush graphics to display.
     //gc.flush();
 
@@ -257,18 +362,13 @@ void VpGrid::drawCrossGrid(GridGC &gridGC)
 
      // Assuming QPainter has already established begin().
      gc->setRenderHint(QPainter::Antialiasing, true);
+     updatePens();
 
      if (m_referenceStyle == VpGrid::REFSTYLE_SQUARE)
      {
-         // Set the pen.
-         QPen pen;
-         pen.setStyle(Qt::NoPen);
-         gc->setPen(pen);
-         // Set the brush.
-         QBrush brush;
-         brush.setColor(m_referenceColor);
-         brush.setStyle(Qt::SolidPattern);
-         gc->setBrush(brush);
+         // Set no pen, and the brush.
+         gc->setPen(Qt::NoPen);
+         gc->setBrush(m_referenceBrush);
 
          QRectF origin;
          origin.setLeft(-1.5 + m_xAlignment);
@@ -279,25 +379,15 @@ void VpGrid::drawCrossGrid(GridGC &gridGC)
          gc->drawRect(origin);
      } else if (m_referenceStyle == VpGrid::REFSTYLE_CIRCLE)
      {
-         // Set the pen.
-         QPen pen;
-         pen.setStyle(Qt::NoPen);
-         gc->setPen(pen);
-         // Set the brush.
-         QBrush brush;
-         brush.setColor(m_referenceColor);
-         brush.setStyle(Qt::SolidPattern);
-         gc->setBrush(brush);
+         // Set no pen, and the brush.
+         gc->setPen(Qt::NoPen);
+         gc->setBrush(m_referenceBrush);
 
          gc->drawEllipse(QPoint(m_xAlignment, m_yAlignment), 2, 2);
      } else
      {
          // Set the pen, no brush.
-         QPen pen;
-         pen.setColor(m_referenceColor);
-         pen.setStyle(Qt::SolidLine);
-         pen.setWidth(2);
-         gc->setPen(pen);
+         gc->setPen(m_referencePen);
 
          // Create a 'X' pattern.
          QLineF cross[2];
@@ -309,85 +399,105 @@ void VpGrid::drawCrossGrid(GridGC &gridGC)
      //delete gc;
  }
 
-#if 0
-void AuGrid::drawCrossGrid2(GridContext &gridGC)
+void VpGrid::updatePens()
 {
-    AuViewportGC *vpgc = gridGC.m_gc;
-    QPainter *gc = new QPainter(vpgc->getGC());
-
-    Device device = Display.getCurrent();
-    Image pixelArray = new Image(device, gridGC.m_truexur - gridGC.m_truexll, 1);
-    Image pixelArrayCross = new Image(device, gridGC.m_truexur - gridGC.m_truexll, 1);
-
-    GC pixelArrayGC = new GC(pixelArray);
-    GC pixelArrayCrossGC = new GC(pixelArrayCross);
-    try {
-        org.eclipse.swt.graphics.Color foregroundColor = new org.eclipse.swt.graphics.Color(device,
-                m_color.getRed(), m_color.getGreen(), m_color.getBlue());
-        Color vpBackgroundColor = gc.getBackground();
-        org.eclipse.swt.graphics.Color backgroundColor = new org.eclipse.swt.graphics.Color(device,
-            vpBackgroundColor.getRed(),	vpBackgroundColor.getGreen(), vpBackgroundColor.getBlue());
-
-        pixelArrayGC.setForeground(foregroundColor);
-        pixelArrayGC.setBackground(backgroundColor);
-        pixelArrayGC.setLineStyle(STYLE_DOT);
-        pixelArrayGC.fillRectangle(0, 0, gridGC.m_truexur - gridGC.m_truexll, 1);
-
-        pixelArrayCrossGC.setForeground(foregroundColor);
-        pixelArrayCrossGC.setBackground(backgroundColor);
-        pixelArrayCrossGC.setLineStyle(STYLE_DOT);
-        pixelArrayCrossGC.fillRectangle(0, 0, gridGC.m_truexur - gridGC.m_truexll, 1);
-    } catch (Exception ex)
+    // Setting a color only detaches a pen the painter still shares, which
+    // happens once per change of color. The brushes start out empty.
+    if ((m_gridBrush.style() == Qt::NoBrush) || (m_gridPen.color() != m_color))
     {
-        System.out.println("Unable to draw cross: " +
-                ex.getMessage());
+        m_gridPen.setColor(m_color);
+        m_gridBrush = QBrush(m_color, Qt::SolidPattern);
     }
-
-    for (int i = 0; i <= gridGC.m_xnum; i++)
+    if ((m_referenceBrush.style() == Qt::NoBrush) || (m_referencePen.color() != m_referenceColor))
     {
-        int x = gridGC.m_xll + (i * gridGC.m_dx);
-        int y = gridGC.m_yll;
+        m_referencePen = QPen(m_referenceColor, 2, Qt::SolidLine);
+        m_referenceBrush = QBrush(m_referenceColor, Qt::SolidPattern);
+    }
+}
 
-        // Convert world coordinates to device coordinates.
-        VpCoord coord = ((VpGraphics2D)gc.m_viewport).worldToDev(x, y);
+bool VpGrid::drawStampedGrid(GridGC &gridGC, bool cross)
+{
+    int x, y, px, minx, maxx, armx, army, width, height;
+    VpGC *vpgc = gridGC.m_gc;
+    QPainter *gc = vpgc->getGC();
 
-        if (((coord.m_x - 1) >= gridGC.m_truexll) && ((coord.m_x + 1) <= gridGC.m_truexur))
-        {
-            pixelArrayGC.drawOval(coord.m_x - gridGC.m_truexll - 1, 0, 1, 1);
-            pixelArrayGC.drawOval(coord.m_x - gridGC.m_truexll, 0, 1, 1);
-            pixelArrayGC.drawOval(coord.m_x - gridGC.m_truexll + 1, 0, 1, 1);
-            pixelArrayCrossGC.drawOval(coord.m_x - gridGC.m_truexll, 0, 1, 1);
-        }
-    }
+    // Stamping works in device space, so world rows must stay device rows.
+    // The stamp is built in device pixels, as the vector path's cosmetic
+    // pens draw, so take the device pixel ratio of a HiDPI target into
+    // account.
+    QTransform xf = gc->combinedTransform();
+    if (xf.type() > QTransform::TxScale)
+        return false;
+    qreal ratio = gc->device()->devicePixelRatioF();
+    xf *= QTransform::fromScale(ratio, ratio);
 
-    for (int j = 0; j <= gridGC.m_ynum; j++)
+    int cols = gridGC.m_xnum;
+    int rows = gridGC.m_ynum + 1;
+    if ((cols <= 0) || (rows <= 0))
+        return true;
+
+    // Find the device column of every grid column.
+    if (m_columns.size() < cols)
+        m_columns.resize(cols);
+    int *columns = m_columns.data();
+    minx = maxx = qRound(xf.m11() * gridGC.m_xll + xf.dx());
+    for (int j = 0; j < cols; j++)
     {
-        int x = gridGC.m_xll;
-        int y = gridGC.m_yll + (j * gridGC.m_dy);
+        x = (int) (gridGC.m_xll + ((qint64) j * gridGC.m_dx));
+        columns[j] = qRound(xf.m11() * x + xf.dx());
+        if (columns[j] < minx) minx = columns[j];
+        if (columns[j] > maxx) maxx = columns[j];
+    }
+
+    // A cross has arms one world unit long, as in drawCrossGrid().
+    armx = cross ? qAbs(qRound(xf.m11())) : 0;
+    army = cross ? qAbs(qRound(xf.m22())) : 0;
+    width = maxx - minx + 1 + 2 * armx;
+    height = 1 + 2 * army;
 
-        // Convert world coordinates to device coordinates.
-        VpCoord coord = ((VpGraphics2D)gc.m_viewport).worldToDev(x, y);
+    // Render one row of the pattern; the image is reused between frames.
+    if ((m_stamp.width() < width) || (m_stamp.height() != height))
+        m_stamp = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+    m_stamp.setDevicePixelRatio(ratio);
+    m_stamp.fill(0);
 
-        if (((coord.m_y - 1) >= gridGC.m_trueyll) && ((coord.m_y + 1) <= gridGC.m_trueyur))
+    QRgb rgba = m_color.rgba();
+    int alpha = qAlpha(rgba);
+    QRgb pixel = qRgba(qRed(rgba) * alpha / 255, qGreen(rgba) * alpha / 255,
+                       qBlue(rgba) * alpha / 255, alpha);
+
+    for (int r = 0; r < height; r++)
+    {
+        QRgb *line = (QRgb *) m_stamp.scanLine(r);
+        for (int j = 0; j < cols; j++)
         {
-            try {
-                gc.drawImage(pixelArrayCross, gridGC.m_truexll, coord.m_y - 1);
-                gc.drawImage(pixelArray, gridGC.m_truexll, coord.m_y);
-                gc.drawImage(pixelArrayCross, gridGC.m_truexll, coord.m_y + 1);
-            } catch (Exception ex) {
-                System.out.println("Unable to draw cross: " +
-                    ex.getMessage());
-            }
+            px = columns[j] - minx + armx;
+            if (r == army)
+            {
+                // The horizontal arm (or the dot itself).
+                for (int k = px - armx; k <= px + armx; k++)
+                    line[k] = pixel;
+            } else
+                // The vertical arm.
+                line[px] = pixel;
         }
     }
 
-    // Flush graphics to display.
-    //gc.flush();
+    // Stamp the row once for every grid row. The painter works in device
+    // independent pixels, so device positions are divided by the ratio;
+    // the stamp's own ratio maps each of its pixels onto one device pixel.
+    gc->save();
+    gc->resetTransform();
+    for (int i = 0; i < rows; i++)
+    {
+        if (isExpired(gridGC))
+            break;
+        y = (int) (gridGC.m_yll + ((qint64) i * gridGC.m_dy));
+        int row = qRound(xf.m22() * y + xf.dy());
+        gc->drawImage(QPointF((minx - armx) / ratio, (row - army) / ratio), m_stamp,
+                      QRectF(0, 0, width, height));
+    }
+    gc->restore();
 
-    // Dispose of the cross image resources.
-    pixelArrayGC.dispose();
-    pixelArrayCrossGC.dispose();
-    pixelArray.dispose();
-    pixelArrayCross.dispose();
+    return true;
 }
-#endif /* 0 */
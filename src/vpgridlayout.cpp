@@ -0,0 +1,137 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+// Include Qt header files.
+#include <QtGlobal>
+
+// Include QtVp header files.
+#include "vpgridlayout.h"
+
+// The range of coordinates a primitive may be drawn at.
+static const qint64 g_minCoord = -0x7fffffffLL - 1;
+static const qint64 g_maxCoord = 0x7fffffffLL;
+
+// Snap a coordinate to the nearest multiple of the spacing, offset by the
+// alignment. Identical to VpGrid::snapToGrid() wherever that does not
+// overflow.
+static qint64 snap(qint64 value, int spacing, int alignment)
+{
+    double q = ((double)(value - alignment)) / ((double) spacing);
+    qint64 n = (qint64) ((q < 0.0) ? (q - 0.5) : (q + 0.5));
+    return (n * spacing) + alignment;
+}
+
+// Snap an axis of the extent, trim it to the int range by whole steps and
+// return the number of grid positions from the lower to the upper bound.
+static int layoutAxis(qint64 lo, qint64 hi, int spacing, int alignment,
+                      int *ll, int *ur)
+{
+    // Declare local variables.
+    qint64 sll, sur;
+
+    sll = snap(lo, spacing, alignment);
+    sur = snap(hi, spacing, alignment);
+    if (sll < g_minCoord)
+        sll += ((g_minCoord - sll + spacing - 1) / spacing) * spacing;
+    if (sur > g_maxCoord)
+        sur -= ((sur - g_maxCoord + spacing - 1) / spacing) * spacing;
+
+    *ll = (int) sll;
+    *ur = (int) sur;
+    return (sur >= sll) ? (int) ((sur - sll) / spacing + 1) : 0;
+}
+
+VpGridLayout::VpGridLayout()
+    : m_valid(false), m_wxmin(0), m_wymin(0), m_wxmax(0), m_wymax(0),
+      m_dx(0), m_dy(0), m_xalignment(0), m_yalignment(0),
+      m_style(VpGrid::STYLE_UNKNOWN),
+      m_xll(0), m_yll(0), m_xur(0), m_yur(0), m_xnum(0), m_ynum(0)
+{
+    // Do nothing extra.
+}
+
+void VpGridLayout::compute(int wxmin, int wymin, int wxmax, int wymax,
+                           int dx, int dy, int xalignment, int yalignment,
+                           VpGrid::Style style)
+{
+    // Declare local variables.
+    qint64 halfdx, halfdy;
+    int xnum, ynum;
+
+    m_valid = true;
+    m_wxmin = wxmin;
+    m_wymin = wymin;
+    m_wxmax = wxmax;
+    m_wymax = wymax;
+    m_dx = dx;
+    m_dy = dy;
+    m_xalignment = xalignment;
+    m_yalignment = yalignment;
+    m_style = style;
+
+    halfdx = dx >> 1;
+    halfdy = dy >> 1;
+
+    // Dots are kept inside the extent; lines and crosses cover it with a
+    // half step of margin.
+    if (style == VpGrid::STYLE_DOT)
+    {
+        halfdx = -halfdx;
+        halfdy = -halfdy;
+    }
+
+    xnum = layoutAxis((qint64) wxmin - halfdx, (qint64) wxmax + halfdx, dx, xalignment,
+                      &m_xll, &m_xur);
+    ynum = layoutAxis((qint64) wymin - halfdy, (qint64) wymax + halfdy, dy, yalignment,
+                      &m_yll, &m_yur);
+
+    // Each style counts its primitives from the grid positions differently.
+    switch (style)
+    {
+        case VpGrid::STYLE_DOT:
+            m_xnum = xnum;
+            m_ynum = ynum - 1;
+            break;
+        case VpGrid::STYLE_CROSS:
+            m_xnum = xnum - 1;
+            m_ynum = ynum - 1;
+            break;
+        default:
+            m_xnum = xnum;
+            m_ynum = ynum;
+            break;
+    }
+}
+
+bool VpGridLayout::isLayoutOf(int wxmin, int wymin, int wxmax, int wymax,
+                              int dx, int dy, int xalignment, int yalignment,
+                              VpGrid::Style style) const
+{
+    return (m_valid &&
+            (m_wxmin == wxmin) && (m_wymin == wymin) &&
+            (m_wxmax == wxmax) && (m_wymax == wymax) &&
+            (m_dx == dx) && (m_dy == dy) &&
+            (m_xalignment == xalignment) && (m_yalignment == yalignment) &&
+            (m_style == style));
+}
@@ -0,0 +1,99 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include Qt header files.
+#include <QHash>
+
+// Include QtVp header files.
+#include "vpgridtilecache.h"
+
+VpGridTileKey::VpGridTileKey()
+    : m_xscale(0), m_yscale(0), m_xphase(0), m_yphase(0), m_ratio(1),
+      m_style(0), m_color(0), m_xSpacing(0), m_ySpacing(0), m_multiplier(0),
+      m_xAlignment(0), m_yAlignment(0), m_xResolution(0), m_yResolution(0), m_adaptive(false),
+      m_tx(0), m_ty(0)
+{
+    // Do nothing extra.
+}
+
+void VpGridTileKey::setGrid(VpGrid &grid)
+{
+    m_style = grid.getStyle();
+    m_color = grid.getColor().rgba();
+    m_xSpacing = grid.getXSpacing();
+    m_ySpacing = grid.getYSpacing();
+    m_multiplier = grid.getMultiplier();
+    m_xAlignment = grid.getXAlignment();
+    m_yAlignment = grid.getYAlignment();
+    m_xResolution = grid.getXResolution();
+    m_yResolution = grid.getYResolution();
+    m_adaptive = grid.isAdaptive();
+}
+
+bool VpGridTileKey::operator==(const VpGridTileKey &key) const
+{
+    return ((m_tx == key.m_tx) && (m_ty == key.m_ty) &&
+            (m_xscale == key.m_xscale) && (m_yscale == key.m_yscale) &&
+            (m_xphase == key.m_xphase) && (m_yphase == key.m_yphase) &&
+            (m_ratio == key.m_ratio) && (m_style == key.m_style) &&
+            (m_color == key.m_color) &&
+            (m_xSpacing == key.m_xSpacing) && (m_ySpacing == key.m_ySpacing) &&
+            (m_multiplier == key.m_multiplier) &&
+            (m_xAlignment == key.m_xAlignment) && (m_yAlignment == key.m_yAlignment) &&
+            (m_xResolution == key.m_xResolution) && (m_yResolution == key.m_yResolution) &&
+            (m_adaptive == key.m_adaptive));
+}
+
+uint qHash(const VpGridTileKey &key)
+{
+    // Mix the fields that vary most between tiles of a view.
+    uint h = qHash(key.m_tx);
+    h = h * 31 + qHash(key.m_ty);
+    // The scales may be negative (y usually is), so round them to a
+    // signed integer; converting a negative double to unsigned is undefined.
+    h = h * 31 + qHash(qRound64(key.m_xscale * 1.0e6));
+    h = h * 31 + qHash(qRound64(key.m_yscale * 1.0e6));
+    h = h * 31 + key.m_color;
+    h = h * 31 + uint(key.m_xSpacing * key.m_multiplier);
+    h = h * 31 + uint(key.m_ySpacing * key.m_multiplier);
+    h = h * 31 + uint(key.m_style);
+    return h;
+}
+
+VpGridTileCache::VpGridTileCache(int budget)
+    : m_tiles(budget)
+{
+    // Do nothing extra.
+}
+
+VpGridTileCache::~VpGridTileCache()
+{
+    // Do nothing; the cache deletes its tiles.
+}
+
+void VpGridTileCache::insert(const VpGridTileKey &key, QPixmap *tile)
+{
+    // Cost the tile by its memory footprint, in kilobytes.
+    int cost = (tile->width() * tile->height() * tile->depth() / 8) / 1024;
+    m_tiles.insert(key, tile, (cost > 0) ? cost : 1);
+}
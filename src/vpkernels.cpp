@@ -0,0 +1,293 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include QtVp header files.
+#include "vputil.h"
+#include "vpkernels.h"
+
+// Determine which vector instruction sets may be compiled in. SSE2 must be
+// enabled for the whole build; AVX2 is enabled per function and only used
+// when the CPU reports it at runtime.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VP_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(VP_HAVE_SSE2)
+#if defined(__GNUC__)
+#define VP_HAVE_AVX2 1
+#define VP_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (_MSC_VER >= 1700)
+#define VP_HAVE_AVX2 1
+#define VP_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+VpKernels::Isa VpKernels::g_isa = VpKernels::getSupportedIsa();
+
+VpKernels::VpKernels()
+{
+    // Do nothing extra.
+}
+
+VpKernels::Isa VpKernels::getSupportedIsa()
+{
+#if defined(VP_HAVE_AVX2) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return ISA_AVX2;
+#elif defined(VP_HAVE_AVX2) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        // AVX2 needs both the CPU feature and OS support for the YMM state.
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6))
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return ISA_AVX2;
+        }
+    }
+#endif
+
+#if defined(VP_HAVE_SSE2)
+    return ISA_SSE2;
+#else
+    return ISA_SCALAR;
+#endif
+}
+
+VpKernels::Isa VpKernels::getIsa()
+{
+    return g_isa;
+}
+
+void VpKernels::setIsa(Isa isa)
+{
+    Isa supported = getSupportedIsa();
+    g_isa = (isa > supported) ? supported : isa;
+}
+
+// Scalar kernels. These define the results all other kernels must reproduce.
+
+// Map points by dst = round(src * scale + offset), in double precision as
+// QTransform::map() does for a scaling matrix. Both mapping directions use
+// this kernel, each with its own matrix.
+static void mapScalar(const int *src, int *dst, int count,
+    double xscale, double yscale, double xoffset, double yoffset)
+{
+    for (int i = 0; i < count; i++)
+    {
+        double fx = (src[2*i] * xscale) + xoffset;
+        double fy = (src[2*i+1] * yscale) + yoffset;
+        dst[2*i] = VpUtil::round(fx);
+        dst[2*i+1] = VpUtil::round(fy);
+    }
+}
+
+static void snapToGridScalar(const int *src, int *dst, int count,
+    int xspacing, int yspacing, int xalignment, int yalignment)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int x = src[2*i];
+        int y = src[2*i+1];
+        dst[2*i] = VpUtil::round(((double)(x - xalignment))/((double)(xspacing))) * xspacing + xalignment;
+        dst[2*i+1] = VpUtil::round(((double)(y - yalignment))/((double)(yspacing))) * yspacing + yalignment;
+    }
+}
+
+#if defined(VP_HAVE_SSE2)
+
+// VpUtil::round() for two doubles: add 0.5 with the sign of the value, then truncate.
+static inline __m128i roundPd(__m128d v)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    return _mm_cvttpd_epi32(_mm_add_pd(v, _mm_or_pd(half, _mm_and_pd(v, sign))));
+}
+
+// 32-bit multiply keeping the low 32 bits; SSE2 lacks _mm_mullo_epi32.
+static inline __m128i mulloEpi32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static void mapSse2(const int *src, int *dst, int count,
+    double xscale, double yscale, double xoffset, double yoffset)
+{
+    const __m128d scale = _mm_setr_pd(xscale, yscale);
+    const __m128d offset = _mm_setr_pd(xoffset, yoffset);
+
+    // Two points per iteration, one per double vector.
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + 2*i));
+        __m128i lo = roundPd(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(v), scale), offset));
+        __m128i hi = roundPd(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), scale), offset));
+        _mm_storeu_si128((__m128i *) (dst + 2*i), _mm_unpacklo_epi64(lo, hi));
+    }
+    mapScalar(src + 2*i, dst + 2*i, count - i, xscale, yscale, xoffset, yoffset);
+}
+
+static void snapToGridSse2(const int *src, int *dst, int count,
+    int xspacing, int yspacing, int xalignment, int yalignment)
+{
+    const __m128i spacing = _mm_setr_epi32(xspacing, yspacing, xspacing, yspacing);
+    const __m128i alignment = _mm_setr_epi32(xalignment, yalignment, xalignment, yalignment);
+    const __m128d dspacing = _mm_setr_pd((double) xspacing, (double) yspacing);
+
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i v = _mm_sub_epi32(_mm_loadu_si128((const __m128i *) (src + 2*i)), alignment);
+        __m128i lo = roundPd(_mm_div_pd(_mm_cvtepi32_pd(v), dspacing));
+        __m128i hi = roundPd(_mm_div_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), dspacing));
+        __m128i n = _mm_unpacklo_epi64(lo, hi);
+        _mm_storeu_si128((__m128i *) (dst + 2*i), _mm_add_epi32(mulloEpi32(n, spacing), alignment));
+    }
+    snapToGridScalar(src + 2*i, dst + 2*i, count - i, xspacing, yspacing, xalignment, yalignment);
+}
+
+#endif /* VP_HAVE_SSE2 */
+
+#if defined(VP_HAVE_AVX2)
+
+// VpUtil::round() for four doubles.
+VP_TARGET_AVX2
+static inline __m128i roundPd256(__m256d v)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    return _mm256_cvttpd_epi32(_mm256_add_pd(v, _mm256_or_pd(half, _mm256_and_pd(v, sign))));
+}
+
+VP_TARGET_AVX2
+static void mapAvx2(const int *src, int *dst, int count,
+    double xscale, double yscale, double xoffset, double yoffset)
+{
+    const __m256d scale = _mm256_setr_pd(xscale, yscale, xscale, yscale);
+    const __m256d offset = _mm256_setr_pd(xoffset, yoffset, xoffset, yoffset);
+
+    // Four points per iteration, two per double vector.
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + 2*i));
+        __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+        __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+        __m128i rlo = roundPd256(_mm256_add_pd(_mm256_mul_pd(lo, scale), offset));
+        __m128i rhi = roundPd256(_mm256_add_pd(_mm256_mul_pd(hi, scale), offset));
+        _mm256_storeu_si256((__m256i *) (dst + 2*i),
+                            _mm256_inserti128_si256(_mm256_castsi128_si256(rlo), rhi, 1));
+    }
+    mapScalar(src + 2*i, dst + 2*i, count - i, xscale, yscale, xoffset, yoffset);
+}
+
+VP_TARGET_AVX2
+static void snapToGridAvx2(const int *src, int *dst, int count,
+    int xspacing, int yspacing, int xalignment, int yalignment)
+{
+    const __m128i spacing = _mm_setr_epi32(xspacing, yspacing, xspacing, yspacing);
+    const __m128i alignment = _mm_setr_epi32(xalignment, yalignment, xalignment, yalignment);
+    const __m256d dspacing = _mm256_setr_pd((double) xspacing, (double) yspacing,
+                                            (double) xspacing, (double) yspacing);
+
+    // Two points per iteration; the divide works on four doubles at once.
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i v = _mm_sub_epi32(_mm_loadu_si128((const __m128i *) (src + 2*i)), alignment);
+        __m128i n = roundPd256(_mm256_div_pd(_mm256_cvtepi32_pd(v), dspacing));
+        _mm_storeu_si128((__m128i *) (dst + 2*i), _mm_add_epi32(_mm_mullo_epi32(n, spacing), alignment));
+    }
+    snapToGridScalar(src + 2*i, dst + 2*i, count - i, xspacing, yspacing, xalignment, yalignment);
+}
+
+#endif /* VP_HAVE_AVX2 */
+
+// Run the map kernel for the instruction set in use.
+static void map(VpKernels::Isa isa, const int *src, int *dst, int count,
+    double xscale, double yscale, double xoffset, double yoffset)
+{
+    switch (isa)
+    {
+#if defined(VP_HAVE_AVX2)
+        case VpKernels::ISA_AVX2:
+            mapAvx2(src, dst, count, xscale, yscale, xoffset, yoffset);
+            break;
+#endif
+#if defined(VP_HAVE_SSE2)
+        case VpKernels::ISA_SSE2:
+            mapSse2(src, dst, count, xscale, yscale, xoffset, yoffset);
+            break;
+#endif
+        default:
+            mapScalar(src, dst, count, xscale, yscale, xoffset, yoffset);
+            break;
+    }
+}
+
+void VpKernels::worldToDev(const int *src, int *dst, int count,
+    double xscale, double yscale, double xoffset, double yoffset)
+{
+    map(g_isa, src, dst, count, xscale, yscale, xoffset, yoffset);
+}
+
+void VpKernels::devToWorld(const int *src, int *dst, int count,
+    double xinvscale, double yinvscale, double xinvoffset, double yinvoffset)
+{
+    map(g_isa, src, dst, count, xinvscale, yinvscale, xinvoffset, yinvoffset);
+}
+
+void VpKernels::snapToGrid(const int *src, int *dst, int count,
+    int xspacing, int yspacing, int xalignment, int yalignment)
+{
+    switch (g_isa)
+    {
+#if defined(VP_HAVE_AVX2)
+        case ISA_AVX2:
+            snapToGridAvx2(src, dst, count, xspacing, yspacing, xalignment, yalignment);
+            break;
+#endif
+#if defined(VP_HAVE_SSE2)
+        case ISA_SSE2:
+            snapToGridSse2(src, dst, count, xspacing, yspacing, xalignment, yalignment);
+            break;
+#endif
+        default:
+            snapToGridScalar(src, dst, count, xspacing, yspacing, xalignment, yalignment);
+            break;
+    }
+}
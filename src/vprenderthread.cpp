@@ -0,0 +1,218 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include Qt header files.
+#include <QMutexLocker>
+#include <QPainter>
+#include <QTransform>
+#include <QRectF>
+
+// Include QtVp header files.
+#include "vprenderthread.h"
+#include "vpgc.h"
+#include "gridgc.h"
+
+VpRenderThread::VpRenderThread(QObject *parent)
+    : QThread(parent), m_abort(false), m_pending(false),
+      m_frameReady(false), m_frontGridDrawn(true)
+{
+    m_request.m_mode = VpGraphics2D::COORD_INT;
+    m_request.m_pw = 0;
+    m_request.m_ph = 0;
+    m_request.m_ratio = 1;
+
+    // The snapshots are never parented; each thread only touches its own.
+    m_requestGrid = new VpGrid();
+    m_requestList = new VpDisplayList();
+    m_workGrid = new VpGrid();
+    m_workList = new VpDisplayList();
+}
+
+VpRenderThread::~VpRenderThread()
+{
+    m_mutex.lock();
+    m_abort = true;
+    m_deadline.cancel();
+    m_condition.wakeOne();
+    m_mutex.unlock();
+    wait();
+
+    delete m_requestGrid;
+    delete m_requestList;
+    delete m_workGrid;
+    delete m_workList;
+}
+
+void VpRenderThread::request(const VpTransform &transform, VpGraphics2D::CoordMode mode,
+                             double pw, double ph, const QSize &size, qreal ratio,
+                             const QColor &background, VpGrid &grid, const VpDisplayList &list)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // A request not yet started is simply replaced.
+    m_request.m_transform = transform;
+    m_request.m_mode = mode;
+    m_request.m_pw = pw;
+    m_request.m_ph = ph;
+    m_request.m_size = size;
+    m_request.m_ratio = ratio;
+    m_request.m_background = background;
+    m_requestGrid->copy(grid);
+    m_requestList->copy(list);
+    m_pending = true;
+
+    // The frame being rendered, if any, is stale now; stop it.
+    m_deadline.cancel();
+
+    if (! isRunning())
+        start(QThread::LowPriority);
+    else
+        m_condition.wakeOne();
+}
+
+bool VpRenderThread::getFrame(QImage *image, VpTransform *transform, bool *gridDrawn)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (! m_frameReady)
+        return false;
+
+    // Exchange the frames rather than share one, which would make the
+    // worker detach, and so copy, it when it next renders into it.
+    image->swap(m_front);
+    *transform = m_frontTransform;
+    *gridDrawn = m_frontGridDrawn;
+    m_frameReady = false;
+    return true;
+}
+
+void VpRenderThread::run()
+{
+    // Declare local variables.
+    Request request;
+    bool gridDrawn;
+
+    while (true)
+    {
+        // Wait for a request and take a snapshot of it.
+        m_mutex.lock();
+        while ((! m_pending) && (! m_abort))
+            m_condition.wait(&m_mutex);
+        if (m_abort)
+        {
+            m_mutex.unlock();
+            return;
+        }
+        request = m_request;
+        m_workGrid->copy(*m_requestGrid);
+        m_workList->copy(*m_requestList);
+        m_requestList->release();
+        m_pending = false;
+        // Started under the lock, so only a later request cancels it.
+        m_deadline.start(0);
+        m_mutex.unlock();
+
+        gridDrawn = render(request);
+
+        // Let the GUI thread edit its list without copying it.
+        m_workList->release();
+
+        m_mutex.lock();
+        if (m_abort)
+        {
+            m_mutex.unlock();
+            return;
+        }
+        if (m_pending || m_deadline.isStopped())
+        {
+            // A newer request has made the frame stale, and may have cut
+            // it short; drop it.
+            m_mutex.unlock();
+            continue;
+        }
+
+        // Present the frame; the one the GUI thread handed back, or the
+        // one it never took, becomes the back buffer.
+        m_front.swap(m_back);
+        m_frontTransform = request.m_transform;
+        m_frontGridDrawn = gridDrawn;
+        m_frameReady = true;
+        m_mutex.unlock();
+
+        emit frameReady();
+    }
+}
+
+bool VpRenderThread::render(const Request &request)
+{
+    // Declare local variables.
+    bool gridDrawn = true;
+
+    // Size the back buffer to the frame in device pixels.
+    QSize pixelSize = request.m_size * request.m_ratio;
+    if (m_back.size() != pixelSize)
+        m_back = QImage(pixelSize, QImage::Format_ARGB32_Premultiplied);
+    m_back.setDevicePixelRatio(request.m_ratio);
+    m_back.fill(request.m_background);
+
+    // Map the world coordinate extent onto the frame.
+    QPainter painter(&m_back);
+    QTransform render = request.m_transform.getWorldToDevMatrix();
+    painter.setWorldTransform(render);
+
+    // Set up the graphics context; the grid only needs the painter.
+    VpGC vpgc;
+    vpgc.setGC(&painter);
+    vpgc.setDeadline(&m_deadline);
+
+    if (m_workGrid->getState() == VpGrid::STATE_ON)
+        gridDrawn = VpGraphics2D::drawGrid(*m_workGrid, &vpgc, request.m_transform, request.m_mode,
+                                           request.m_pw, request.m_ph, &m_layout);
+
+    if (m_deadline.isStopped())
+    {
+        // The frame is stale; it is dropped, so don't finish it.
+        painter.end();
+        return gridDrawn;
+    }
+
+    // Display the grid reference regardless of whether the grid is on.
+    if (gridDrawn && m_workGrid->isReferenceOn())
+    {
+        GridGC gridGC;
+        gridGC.m_gc = &vpgc;
+        m_workGrid->drawReference(gridGC);
+    }
+
+    // Draw the display list over the grid, in device space.
+    if (m_workList->getCount() > 0)
+    {
+        QRectF clip = request.m_transform.getDevToWorldMatrix().mapRect(
+            QRectF(QPointF(0, 0), QSizeF(request.m_size)));
+        painter.resetTransform();
+        m_workList->draw(&painter, render, clip);
+    }
+
+    painter.end();
+    return gridDrawn;
+}
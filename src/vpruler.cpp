@@ -25,6 +25,14 @@
 #include <QPainter>
 #include <QSize>
 #include <QMouseEvent>
+#include <QTransform>
+#include <QPainterPath>
+#include <QEvent>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QRegion>
+#include <QVector>
+#include <qmath.h>
 #include <QDebug>
 
 // Include QtVp header files.
@@ -33,9 +41,14 @@
 
 VpRuler::VpRuler(QWidget* parent, RulerType rulerType)
     : VpGraphics2D(parent), m_rulerType(rulerType), m_origin(0.), m_rulerUnit(1.), m_rulerZoom(1.),
-      m_mouseTracking(false), m_drawText(false), m_extentTracking(false)
+      m_mouseTracking(false), m_drawText(false), m_extentTracking(false), m_sharing(false),
+      m_tickPen(Qt::black, 0), m_borderPen(Qt::black, 2),
+      m_stripValid(false), m_stripWxmin(0), m_stripWymin(0), m_stripWxmax(0), m_stripWymax(0),
+      m_stripOrigin(0.), m_stripUnit(1.), m_stripZoom(1.)
 {
     setMouseTracking(true);
+    // Rulers follow deep zooms without losing the tick positions.
+    setCoordMode(COORD_DOUBLE);
     QFont txtFont("Goudy Old Style", 5, 20);
     txtFont.setStyleHint(QFont::TypeWriter,QFont::PreferOutline);
     setFont(txtFont);
@@ -99,9 +112,7 @@ void VpRuler::setRulerZoom(const qreal rulerZoom)
 
 void VpRuler::setCursorPos(const QPoint cursorPos)
 {
-    m_cursorPos = this->mapFromGlobal(cursorPos);
-    m_cursorPos += QPoint(RULER_BREADTH,RULER_BREADTH);
-    update();
+    moveCursor(this->mapFromGlobal(cursorPos) + QPoint(RULER_BREADTH,RULER_BREADTH));
 }
 
 void VpRuler::setMouseTrack(const bool track)
@@ -109,53 +120,133 @@ void VpRuler::setMouseTrack(const bool track)
     if (m_mouseTracking != track)
     {
         m_mouseTracking = track;
-        update();
+        update(getIndicatorRect(m_cursorPos));
     }
 }
 
 void VpRuler::mouseMoveEvent(QMouseEvent* event)
 {
-    m_cursorPos = event->pos();
-    update();
+    moveCursor(event->pos());
     QWidget::mouseMoveEvent(event);
 }
 
+void VpRuler::moveCursor(const QPoint &pos)
+{
+    if (m_cursorPos == pos)
+        return;
+
+    // Repaint just where the indicator was and where it is now; the rest
+    // of the ruler is unchanged.
+    if (m_mouseTracking)
+        update(getIndicatorRect(m_cursorPos));
+    m_cursorPos = pos;
+    if (m_mouseTracking)
+        update(getIndicatorRect(m_cursorPos));
+}
+
+QRect VpRuler::getIndicatorRect(const QPoint &cursor)
+{
+    // Locate the indicator as drawMousePosTick() does.
+    double x = cursor.x();
+    double y = cursor.y();
+    devToWorld(&x, &y);
+    QPointF pos = getRulerTransform().map(QPointF(x, y));
+
+    // An antialiased hairline may touch the pixels either side of it.
+    if (Horizontal == m_rulerType)
+        return QRect(qFloor(pos.x()) - INDICATOR_MARGIN, 0, 2 * INDICATOR_MARGIN + 1, height());
+    else
+        return QRect(0, qFloor(pos.y()) - INDICATOR_MARGIN, width(), 2 * INDICATOR_MARGIN + 1);
+}
+
 void VpRuler::paintEvent(QPaintEvent* event)
 {
-    //bool isHorzRuler = Horizontal == m_rulerType;
-    //QString str;
-    //if (isHorzRuler) str.append(tr("Horizontal")); else str.append(tr("Vertical"));
-    //qDebug() << str << "VpRuler Physical: (" << rect().left() << "," << rect().top() << ") - (" << rect().right() << "," << rect().bottom() << ")";
-    //qDebug() << str << "VpRuler World: (" << m_2dWxmin << "," << m_2dWymin << ") - (" << m_2dWxmax << "," << m_2dWymax << ")";
-    //qDebug() << str << "VpRuler Origin: (" << m_Wx << "," << m_Wy << ")";
+    // Regenerate the tick strip only if the mapping or the scale changed.
+    if (! isStripCurrent())
+        renderStrip();
 
     // Create the Qt graphics context.
     QPainter *gc = m_painter;
     gc->begin(this);
+
+    // Copy the damaged areas from the cached strip. Cursor tracking
+    // damages two thin rectangles, which need not be merged.
+    const QRegion &region = event->region();
+    for (QRegion::const_iterator it = region.begin(); it != region.end(); ++it)
+        copyStrip(gc, *it);
+
+    // Drawing the current mouse position indicator.
     gc->setRenderHints(QPainter::TextAntialiasing | QPainter::HighQualityAntialiasing);
+    gc->setWorldTransform(getRulerTransform());
+    gc->setPen(m_tickPen);
+    gc->setOpacity(0.4);
+    drawMousePosTick(gc);
 
-    // Set world coordinate extent.
-    QRect extent;
-    extent.setLeft(getWxmin());
-    extent.setRight(getWxmax());
-    if (Horizontal == m_rulerType) {
-        extent.setTop(getWymin());
-        extent.setBottom(getWymax());
-    } else {
-        extent.setTop(getWymax());
-        extent.setBottom(getWymin());
-    }
-    gc->setWindow(extent);
+    // Complete painting.
+    gc->end();
+}
 
-    QPen pen(Qt::black, 0); // zero width pen is cosmetic pen
-    //pen.setCosmetic(true);
-    gc->setPen(pen);
+void VpRuler::copyStrip(QPainter* painter, const QRect &r)
+{
+    qreal ratio = m_strip.devicePixelRatio();
+    QRect source(QPoint(qRound(r.x() * ratio), qRound(r.y() * ratio)), r.size() * ratio);
+    painter->drawPixmap(r, m_strip, source);
+}
+
+QTransform VpRuler::getRulerTransform()
+{
+    // A shared mapping already fits the ruler.
+    if (m_sharing)
+        return getWorldToDevMatrix();
+
+    // Map the world coordinate extent onto the ruler in double precision;
+    // the vertical ruler is flipped.
+    double wxmin = getWxminF();
+    double wxmax = getWxmaxF();
+    double wytop = (Horizontal == m_rulerType) ? getWyminF() : getWymaxF();
+    double wybottom = (Horizontal == m_rulerType) ? getWymaxF() : getWyminF();
+    if ((wxmax == wxmin) || (wybottom == wytop))
+        return QTransform();
+
+    double xscale = (double) width() / (wxmax - wxmin);
+    double yscale = (double) height() / (wybottom - wytop);
+    return QTransform(xscale, 0, 0, yscale, -wxmin * xscale, -wytop * yscale);
+}
+
+bool VpRuler::isStripCurrent()
+{
+    return (m_stripValid &&
+            (m_strip.devicePixelRatio() == devicePixelRatio()) &&
+            (m_strip.size() == size() * devicePixelRatio()) &&
+            (m_stripWxmin == getWxminF()) && (m_stripWymin == getWyminF()) &&
+            (m_stripWxmax == getWxmaxF()) && (m_stripWymax == getWymaxF()) &&
+            (m_stripOrigin == m_origin) && (m_stripUnit == m_rulerUnit) &&
+            (m_stripZoom == m_rulerZoom));
+}
+
+void VpRuler::renderStrip()
+{
+    // Size the strip to the ruler in device pixels.
+    qreal ratio = devicePixelRatio();
+    QSize pixelSize = size() * ratio;
+    if (m_strip.size() != pixelSize)
+        m_strip = QPixmap(pixelSize);
+    m_strip.setDevicePixelRatio(ratio);
+    m_strip.fill(palette().color(backgroundRole()));
+
+    // Create the Qt graphics context.
+    QPainter *gc = m_painter;
+    gc->begin(&m_strip);
+    gc->setRenderHints(QPainter::TextAntialiasing | QPainter::HighQualityAntialiasing);
+    gc->setWorldTransform(getRulerTransform());
+
+    // A zero width pen is cosmetic.
+    gc->setPen(m_tickPen);
     // We want to work with floating point, so we are considering
     // the rect as QRectF
     QRectF rulerRect;
-    rulerRect.setCoords(m_2dWxmin, m_2dWymin, m_2dWxmax, m_2dWymax);
+    rulerRect.setCoords(getWxminF(), getWyminF(), getWxmaxF(), getWymaxF());
     // First fill the rect.
-    //painter.fillRect(rulerRect,QColor(220,200,180));
     gc->fillRect(rulerRect,QColor(236, 233, 216));
 
     // Drawing a scale of 25.
@@ -167,19 +258,50 @@ void VpRuler::paintEvent(QPaintEvent* event)
     drawAScaleMeter(gc, rulerRect, 100, 0);
     m_drawText = false;
 
-    // Drawing the current mouse position indicator.
-    gc->setOpacity(0.4);
-    drawMousePosTick(gc);
-    gc->setOpacity(1.0);
-
     // Drawing no man's land between the ruler and view.
     QPointF starPt = Horizontal == m_rulerType ? rulerRect.bottomLeft() : rulerRect.topRight();
     QPointF endPt = Horizontal == m_rulerType ? rulerRect.bottomRight() : rulerRect.bottomRight();
-    gc->setPen(QPen(Qt::black,2));
+    gc->setPen(m_borderPen);
     gc->drawLine(starPt,endPt);
 
     // Complete painting.
     gc->end();
+
+    // Remember what the strip shows.
+    m_stripValid = true;
+    m_stripWxmin = getWxminF();
+    m_stripWymin = getWyminF();
+    m_stripWxmax = getWxmaxF();
+    m_stripWymax = getWymaxF();
+    m_stripOrigin = m_origin;
+    m_stripUnit = m_rulerUnit;
+    m_stripZoom = m_rulerZoom;
+}
+
+const QPainterPath &VpRuler::getLabel(int value)
+{
+    QHash<int, QPainterPath>::const_iterator it = m_labels.constFind(value);
+    if (it != m_labels.constEnd())
+        return it.value();
+
+    // Labels are few; start over rather than track their use.
+    if (m_labels.size() >= MAX_LABELS)
+        m_labels.clear();
+
+    QPainterPath label;
+    label.addText(0, 0, this->font(), QString::number(value));
+    return m_labels.insert(value, label).value();
+}
+
+void VpRuler::changeEvent(QEvent* event)
+{
+    // The labels are outlines of the ruler's font.
+    if (event->type() == QEvent::FontChange)
+    {
+        m_labels.clear();
+        m_stripValid = false;
+    }
+    VpGraphics2D::changeEvent(event);
 }
 
 void VpRuler::drawAScaleMeter(QPainter* painter, QRectF rulerRect, qreal scaleMeter, qreal startPosition)
@@ -219,6 +341,7 @@ void VpRuler::drawFromOriginTo(QPainter* painter, QRectF rulerRect, qreal startM
 {
     bool isHorzRuler = Horizontal == m_rulerType;
     int iterate = 0;
+    QTransform base = painter->worldTransform();
     for (qreal current = startMark; (step < 0 ? current >= endMark : current <= endMark); current += step)
     {
         qreal x1 = isHorzRuler ? current : rulerRect.left() + startPosition;
@@ -228,20 +351,22 @@ void VpRuler::drawFromOriginTo(QPainter* painter, QRectF rulerRect, qreal startM
         painter->drawLine(QLineF(x1,y1,x2,y2));
         if (m_drawText)
         {
-            QPainterPath txtPath;
-            txtPath.addText(x1 + 1,y1 + (isHorzRuler ? 7 : -2),this->font(),QString::number(qAbs(int(step) * startTickNo++)));
-            painter->drawPath(txtPath);
+            // Draw the cached label outline at the tick.
+            const QPainterPath &label = getLabel(qAbs(int(step) * startTickNo++));
+            painter->setWorldTransform(QTransform::fromTranslate(x1 + 1, y1 + (isHorzRuler ? 7 : -2)) * base);
+            painter->drawPath(label);
             iterate++;
         }
     }
+    painter->setWorldTransform(base);
 }
 
 void VpRuler::drawMousePosTick(QPainter* painter)
 {
     if (m_mouseTracking)
     {
-        int x = m_cursorPos.x();
-        int y = m_cursorPos.y();
+        double x = m_cursorPos.x();
+        double y = m_cursorPos.y();
         devToWorld(&x, &y);
 
         //QPoint starPt = m_cursorPos;
@@ -277,6 +402,7 @@ void VpRuler::setExtent(const QRect size, const QPoint origin)
 
     m_Wx = origin.x();
     m_Wy = origin.y();
+    m_sharing = false;
 
     bool isHorzRuler = Horizontal == m_rulerType;
     if (isHorzRuler)
@@ -298,6 +424,31 @@ void VpRuler::setExtent(const QRect size, const QPoint origin)
     }
 }
 
+void VpRuler::setExtent(const QRectF size, const QPointF origin)
+{
+    // If the extent is invalid, simply return.
+    if ((! size.isValid()) || size.isNull())
+    {
+        qDebug("Ruler extent: invalid rectangle.");
+        return;
+    }
+
+    m_Wx = origin.x();
+    m_Wy = origin.y();
+    m_sharing = false;
+
+    bool isHorzRuler = Horizontal == m_rulerType;
+    if (isHorzRuler)
+    {
+        // Setting horizontal world extent.
+        setWorldCoords(size.left(), 0.0, size.right(), (double) this->rect().bottom());
+    } else
+    {
+        // Setting vertical world extent.
+        setWorldCoords(0.0, size.top(), (double) this->rect().right(), size.bottom());
+    }
+}
+
 void VpRuler::setExtentTrack(const bool track)
 {
     if (m_extentTracking != track)
@@ -306,3 +457,78 @@ void VpRuler::setExtentTrack(const bool track)
         update();
     }
 }
+
+void VpRuler::setTransform(const VpTransform &transform)
+{
+    // Nothing to do if the snapshot has already been applied.
+    if (m_sharing && (m_sharedTransform.getVersion() == transform.getVersion()))
+        return;
+
+    m_sharedTransform = transform;
+    m_sharing = true;
+    applyTransform();
+    update();
+}
+
+void VpRuler::resizeEvent(QResizeEvent* event)
+{
+    if (! m_sharing)
+    {
+        VpGraphics2D::resizeEvent(event);
+        return;
+    }
+
+    // Only the extent across the ruler depends on its size.
+    QSize size = event->size();
+    setPxmin(0);
+    setPxmax(size.width());
+    setPymin(0);
+    setPymax(size.height());
+    applyTransform();
+}
+
+void VpRuler::applyTransform()
+{
+    const VpTransform &t = m_sharedTransform;
+
+    if (Horizontal == m_rulerType)
+    {
+        // Along the ruler, the content's x mapping.
+        setWxminF(t.getWxminF());
+        setWxmaxF(t.getWxmaxF());
+        setXScaleF(t.getXScaleF());
+        setXOffsetF(t.getXOffsetF());
+        setXScale(t.getXScale());
+        setXOffset(t.getXOffset());
+
+        // Across the ruler, one world unit per pixel.
+        setWyminF(0);
+        setWymaxF(height());
+        setYScaleF(1);
+        setYOffsetF(0);
+        setYScale(1);
+        setYOffset(0);
+    } else
+    {
+        // Along the ruler, the content's (flipped) y mapping.
+        setWyminF(t.getWyminF());
+        setWymaxF(t.getWymaxF());
+        setYScaleF(t.getYScaleF());
+        setYOffsetF(t.getYOffsetF());
+        setYScale(t.getYScale());
+        setYOffset(t.getYOffset());
+
+        // Across the ruler, one world unit per pixel.
+        setWxminF(0);
+        setWxmaxF(width());
+        setXScaleF(1);
+        setXOffsetF(0);
+        setXScale(1);
+        setXOffset(0);
+    }
+    setWxmin(saturate(getWxminF()));
+    setWxmax(saturate(getWxmaxF()));
+    setWymin(saturate(getWyminF()));
+    setWymax(saturate(getWymaxF()));
+    publishTransform();
+}
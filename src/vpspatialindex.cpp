@@ -0,0 +1,470 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+
+// Include Qt header files.
+#include <QVarLengthArray>
+#include <qmath.h>
+#include <algorithm>
+
+// Include QtVp header files.
+#include "vpspatialindex.h"
+
+static bool lessX(const VpSpatialIndex::Entry &a, const VpSpatialIndex::Entry &b)
+{
+    return (a.m_xmin + a.m_xmax) < (b.m_xmin + b.m_xmax);
+}
+
+static bool lessY(const VpSpatialIndex::Entry &a, const VpSpatialIndex::Entry &b)
+{
+    return (a.m_ymin + a.m_ymax) < (b.m_ymin + b.m_ymax);
+}
+
+static void unite(VpSpatialIndex::Entry *bounds, const VpSpatialIndex::Entry &entry)
+{
+    bounds->m_xmin = qMin(bounds->m_xmin, entry.m_xmin);
+    bounds->m_ymin = qMin(bounds->m_ymin, entry.m_ymin);
+    bounds->m_xmax = qMax(bounds->m_xmax, entry.m_xmax);
+    bounds->m_ymax = qMax(bounds->m_ymax, entry.m_ymax);
+}
+
+static double area(const VpSpatialIndex::Entry &entry)
+{
+    return (entry.m_xmax - entry.m_xmin) * (entry.m_ymax - entry.m_ymin);
+}
+
+VpSpatialIndex::VpSpatialIndex()
+    : m_root(-1), m_count(0)
+{
+    // Do nothing extra.
+}
+
+VpSpatialIndex::~VpSpatialIndex()
+{
+    // Do nothing.
+}
+
+void VpSpatialIndex::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_root = -1;
+    m_count = 0;
+}
+
+int VpSpatialIndex::allocNode(bool leaf)
+{
+    // Declare local variables.
+    int node;
+
+    if (! m_freeNodes.isEmpty())
+    {
+        node = m_freeNodes.last();
+        m_freeNodes.removeLast();
+    } else
+    {
+        node = m_nodes.size();
+        m_nodes.resize(node + 1);
+    }
+    m_nodes[node].m_count = 0;
+    m_nodes[node].m_leaf = leaf;
+
+    return node;
+}
+
+void VpSpatialIndex::freeNode(int node, QVector<Entry> *orphans)
+{
+    const Node &n = m_nodes.at(node);
+    for (int i = 0; i < n.m_count; i++)
+    {
+        if (! n.m_leaf)
+            freeNode(n.m_child[i], orphans);
+        else if (orphans != NULL)
+        {
+            Entry entry = { n.m_xmin[i], n.m_ymin[i], n.m_xmax[i], n.m_ymax[i], n.m_child[i] };
+            orphans->append(entry);
+        }
+    }
+    m_freeNodes.append(node);
+}
+
+VpSpatialIndex::Entry VpSpatialIndex::getNodeBounds(int node) const
+{
+    const Node &n = m_nodes.at(node);
+    Entry bounds = { n.m_xmin[0], n.m_ymin[0], n.m_xmax[0], n.m_ymax[0], node };
+    for (int i = 1; i < n.m_count; i++)
+    {
+        bounds.m_xmin = qMin(bounds.m_xmin, n.m_xmin[i]);
+        bounds.m_ymin = qMin(bounds.m_ymin, n.m_ymin[i]);
+        bounds.m_xmax = qMax(bounds.m_xmax, n.m_xmax[i]);
+        bounds.m_ymax = qMax(bounds.m_ymax, n.m_ymax[i]);
+    }
+    return bounds;
+}
+
+void VpSpatialIndex::appendEntry(int node, const Entry &entry)
+{
+    Node &n = m_nodes[node];
+    int i = n.m_count++;
+    n.m_xmin[i] = entry.m_xmin;
+    n.m_ymin[i] = entry.m_ymin;
+    n.m_xmax[i] = entry.m_xmax;
+    n.m_ymax[i] = entry.m_ymax;
+    n.m_child[i] = entry.m_id;
+}
+
+QRectF VpSpatialIndex::getBounds() const
+{
+    if ((m_root < 0) || (m_nodes.at(m_root).m_count == 0))
+        return QRectF();
+
+    Entry bounds = getNodeBounds(m_root);
+    return QRectF(QPointF(bounds.m_xmin, bounds.m_ymin), QPointF(bounds.m_xmax, bounds.m_ymax));
+}
+
+void VpSpatialIndex::insert(int id, double xmin, double ymin, double xmax, double ymax)
+{
+    Entry entry = { xmin, ymin, xmax, ymax, id };
+    insertItem(entry);
+    m_count++;
+}
+
+void VpSpatialIndex::insertItem(const Entry &entry)
+{
+    if (m_root < 0)
+        m_root = allocNode(true);
+
+    int split = insertEntry(m_root, entry);
+    if (split >= 0)
+    {
+        // Grow the tree by a level.
+        int root = allocNode(false);
+        appendEntry(root, getNodeBounds(m_root));
+        appendEntry(root, getNodeBounds(split));
+        m_root = root;
+    }
+}
+
+int VpSpatialIndex::insertEntry(int node, const Entry &entry)
+{
+    if (m_nodes.at(node).m_leaf)
+        appendEntry(node, entry);
+    else
+    {
+        // Descend into the child needing the least enlargement, preferring
+        // the smaller child on a tie.
+        const Node &n = m_nodes.at(node);
+        int best = 0;
+        double bestGrowth = 0, bestArea = 0;
+        for (int i = 0; i < n.m_count; i++)
+        {
+            Entry child = { n.m_xmin[i], n.m_ymin[i], n.m_xmax[i], n.m_ymax[i], n.m_child[i] };
+            double childArea = area(child);
+            unite(&child, entry);
+            double growth = area(child) - childArea;
+            if ((i == 0) || (growth < bestGrowth) ||
+                ((growth == bestGrowth) && (childArea < bestArea)))
+            {
+                best = i;
+                bestGrowth = growth;
+                bestArea = childArea;
+            }
+        }
+
+        int child = n.m_child[best];
+        int split = insertEntry(child, entry);
+
+        // The pool may have grown; look the node up again.
+        Entry bounds = getNodeBounds(child);
+        Node &parent = m_nodes[node];
+        parent.m_xmin[best] = bounds.m_xmin;
+        parent.m_ymin[best] = bounds.m_ymin;
+        parent.m_xmax[best] = bounds.m_xmax;
+        parent.m_ymax[best] = bounds.m_ymax;
+        if (split >= 0)
+            appendEntry(node, getNodeBounds(split));
+    }
+
+    if (m_nodes.at(node).m_count > MAX_ENTRIES)
+        return splitNode(node);
+    return -1;
+}
+
+int VpSpatialIndex::splitNode(int node)
+{
+    // Declare local variables.
+    Entry entries[MAX_ENTRIES + 1];
+    Entry lower[MAX_ENTRIES + 1];
+    Entry upper[MAX_ENTRIES + 1];
+    int count, bestAxis = 0, bestSplit = MIN_ENTRIES;
+    double bestOverlap = 0, bestArea = 0;
+    bool leaf;
+
+    {
+        const Node &n = m_nodes.at(node);
+        count = n.m_count;
+        leaf = n.m_leaf;
+        for (int i = 0; i < count; i++)
+        {
+            Entry entry = { n.m_xmin[i], n.m_ymin[i], n.m_xmax[i], n.m_ymax[i], n.m_child[i] };
+            entries[i] = entry;
+        }
+    }
+
+    // Try every distribution along each axis, keeping the one whose
+    // halves overlap least and, after that, cover the least area.
+    for (int axis = 0; axis < 2; axis++)
+    {
+        std::sort(entries, entries + count, (axis == 0) ? lessX : lessY);
+
+        lower[0] = entries[0];
+        for (int i = 1; i < count; i++)
+        {
+            lower[i] = lower[i - 1];
+            unite(&lower[i], entries[i]);
+        }
+        upper[count - 1] = entries[count - 1];
+        for (int i = count - 2; i >= 0; i--)
+        {
+            upper[i] = upper[i + 1];
+            unite(&upper[i], entries[i]);
+        }
+
+        for (int k = MIN_ENTRIES; k <= count - MIN_ENTRIES; k++)
+        {
+            const Entry &a = lower[k - 1];
+            const Entry &b = upper[k];
+            double w = qMin(a.m_xmax, b.m_xmax) - qMax(a.m_xmin, b.m_xmin);
+            double h = qMin(a.m_ymax, b.m_ymax) - qMax(a.m_ymin, b.m_ymin);
+            double overlap = ((w > 0) && (h > 0)) ? (w * h) : 0;
+            double total = area(a) + area(b);
+            if (((axis == 0) && (k == MIN_ENTRIES)) || (overlap < bestOverlap) ||
+                ((overlap == bestOverlap) && (total < bestArea)))
+            {
+                bestAxis = axis;
+                bestSplit = k;
+                bestOverlap = overlap;
+                bestArea = total;
+            }
+        }
+    }
+
+    if (bestAxis == 0)
+        std::sort(entries, entries + count, lessX);
+
+    int sibling = allocNode(leaf);
+    m_nodes[node].m_count = 0;
+    for (int i = 0; i < bestSplit; i++)
+        appendEntry(node, entries[i]);
+    for (int i = bestSplit; i < count; i++)
+        appendEntry(sibling, entries[i]);
+
+    return sibling;
+}
+
+bool VpSpatialIndex::remove(int id, double xmin, double ymin, double xmax, double ymax)
+{
+    // Declare local variables.
+    Entry entry = { xmin, ymin, xmax, ymax, id };
+    QVector<Entry> orphans;
+
+    if ((m_root < 0) || (! removeEntry(m_root, entry, &orphans)))
+        return false;
+    m_count--;
+
+    // Shorten the tree while the root has a single child.
+    while (m_root >= 0)
+    {
+        const Node &root = m_nodes.at(m_root);
+        if (root.m_count == 0)
+        {
+            m_freeNodes.append(m_root);
+            m_root = -1;
+        } else if ((! root.m_leaf) && (root.m_count == 1))
+        {
+            m_freeNodes.append(m_root);
+            m_root = root.m_child[0];
+        } else
+            break;
+    }
+
+    // Put back the items of the nodes that became underfull.
+    for (int i = 0; i < orphans.size(); i++)
+        insertItem(orphans.at(i));
+
+    return true;
+}
+
+bool VpSpatialIndex::removeEntry(int node, const Entry &entry, QVector<Entry> *orphans)
+{
+    Node &n = m_nodes[node];
+
+    if (n.m_leaf)
+    {
+        for (int i = 0; i < n.m_count; i++)
+        {
+            if (n.m_child[i] != entry.m_id)
+                continue;
+
+            // Entry order within a node does not matter.
+            int last = --n.m_count;
+            n.m_xmin[i] = n.m_xmin[last];
+            n.m_ymin[i] = n.m_ymin[last];
+            n.m_xmax[i] = n.m_xmax[last];
+            n.m_ymax[i] = n.m_ymax[last];
+            n.m_child[i] = n.m_child[last];
+            return true;
+        }
+        return false;
+    }
+
+    for (int i = 0; i < n.m_count; i++)
+    {
+        if ((entry.m_xmin < n.m_xmin[i]) || (entry.m_ymin < n.m_ymin[i]) ||
+            (entry.m_xmax > n.m_xmax[i]) || (entry.m_ymax > n.m_ymax[i]))
+            continue;
+
+        int child = n.m_child[i];
+        if (! removeEntry(child, entry, orphans))
+            continue;
+
+        // Removal never grows the pool, so n is still valid.
+        if (m_nodes.at(child).m_count < MIN_ENTRIES)
+        {
+            freeNode(child, orphans);
+            int last = --n.m_count;
+            n.m_xmin[i] = n.m_xmin[last];
+            n.m_ymin[i] = n.m_ymin[last];
+            n.m_xmax[i] = n.m_xmax[last];
+            n.m_ymax[i] = n.m_ymax[last];
+            n.m_child[i] = n.m_child[last];
+        } else
+        {
+            Entry bounds = getNodeBounds(child);
+            n.m_xmin[i] = bounds.m_xmin;
+            n.m_ymin[i] = bounds.m_ymin;
+            n.m_xmax[i] = bounds.m_xmax;
+            n.m_ymax[i] = bounds.m_ymax;
+        }
+        return true;
+    }
+    return false;
+}
+
+void VpSpatialIndex::load(const QVector<Entry> &items)
+{
+    clear();
+    if (items.isEmpty())
+        return;
+
+    // Pack the items into leaves, then each level into the one above it.
+    QVector<Entry> level = items;
+    bool leaf = true;
+    do
+    {
+        level = packLevel(level, leaf);
+        leaf = false;
+    } while (level.size() > 1);
+
+    m_root = level.at(0).m_id;
+    m_count = items.size();
+}
+
+QVector<VpSpatialIndex::Entry> VpSpatialIndex::packLevel(QVector<Entry> &entries, bool leaf)
+{
+    // Declare local variables.
+    int n = entries.size();
+    int nodes = (n + MAX_ENTRIES - 1) / MAX_ENTRIES;
+    int slices = (int) qCeil(qSqrt((double) nodes));
+    int sliceSize = slices * MAX_ENTRIES;
+    QVector<Entry> parents;
+
+    // Cut the entries into vertical slices, sort each slice by y and fill
+    // nodes from it in order.
+    Entry *data = entries.data();
+    std::sort(data, data + n, lessX);
+    parents.reserve(nodes + slices);
+    for (int s = 0; s < n; s += sliceSize)
+    {
+        int end = qMin(s + sliceSize, n);
+        std::sort(data + s, data + end, lessY);
+        for (int i = s; i < end; i += MAX_ENTRIES)
+        {
+            int node = allocNode(leaf);
+            int last = qMin(i + MAX_ENTRIES, end);
+            for (int j = i; j < last; j++)
+                appendEntry(node, data[j]);
+            parents.append(getNodeBounds(node));
+        }
+    }
+
+    return parents;
+}
+
+void VpSpatialIndex::query(const QRectF &rect, QVector<int> *ids) const
+{
+    QRectF r = rect.normalized();
+    search(r.left(), r.top(), r.right(), r.bottom(), false, ids);
+}
+
+void VpSpatialIndex::queryContained(const QRectF &rect, QVector<int> *ids) const
+{
+    QRectF r = rect.normalized();
+    search(r.left(), r.top(), r.right(), r.bottom(), true, ids);
+}
+
+void VpSpatialIndex::query(const QPointF &point, QVector<int> *ids) const
+{
+    search(point.x(), point.y(), point.x(), point.y(), false, ids);
+}
+
+void VpSpatialIndex::search(double xmin, double ymin, double xmax, double ymax,
+                            bool contained, QVector<int> *ids) const
+{
+    if (m_root < 0)
+        return;
+
+    // Walk the tree without recursion; the stack stays shallow.
+    const Node *nodes = m_nodes.constData();
+    QVarLengthArray<int, 256> stack;
+    stack.append(m_root);
+    while (! stack.isEmpty())
+    {
+        const Node &n = nodes[stack.last()];
+        stack.removeLast();
+
+        for (int i = 0; i < n.m_count; i++)
+        {
+            if ((n.m_xmax[i] < xmin) || (n.m_xmin[i] > xmax) ||
+                (n.m_ymax[i] < ymin) || (n.m_ymin[i] > ymax))
+                continue;
+
+            if (! n.m_leaf)
+                stack.append(n.m_child[i]);
+            else if ((! contained) ||
+                     ((n.m_xmin[i] >= xmin) && (n.m_xmax[i] <= xmax) &&
+                      (n.m_ymin[i] >= ymin) && (n.m_ymax[i] <= ymax)))
+                ids->append(n.m_child[i]);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include QtVp header files.
+#include "vptransform.h"
+
+VpTransform::VpTransform()
+    : m_wxmin(0), m_wymin(0), m_wxmax(0), m_wymax(0),
+      m_xscale(0), m_yscale(0), m_xoffset(0), m_yoffset(0), m_version(0),
+      m_wxminF(0), m_wyminF(0), m_wxmaxF(0), m_wymaxF(0),
+      m_xscaleF(0), m_yscaleF(0), m_xoffsetF(0), m_yoffsetF(0),
+      m_xinvscale(0), m_yinvscale(0),
+      m_xinvscaleF(0), m_yinvscaleF(0), m_xinvoffsetF(0), m_yinvoffsetF(0)
+{
+    // Do nothing extra.
+}
+
+VpTransform::VpTransform(int wxmin, int wymin, int wxmax, int wymax,
+                         float xscale, float yscale, float xoffset, float yoffset,
+                         unsigned int version)
+    : m_wxmin(wxmin), m_wymin(wymin), m_wxmax(wxmax), m_wymax(wymax),
+      m_xscale(xscale), m_yscale(yscale), m_xoffset(xoffset), m_yoffset(yoffset),
+      m_version(version),
+      m_wxminF(wxmin), m_wyminF(wymin), m_wxmaxF(wxmax), m_wymaxF(wymax),
+      m_xscaleF(xscale), m_yscaleF(yscale), m_xoffsetF(xoffset), m_yoffsetF(yoffset)
+{
+    setMappingF(xscale, yscale, xoffset, yoffset);
+}
+
+void VpTransform::setExtentF(double wxmin, double wymin, double wxmax, double wymax)
+{
+    m_wxminF = wxmin;
+    m_wyminF = wymin;
+    m_wxmaxF = wxmax;
+    m_wymaxF = wymax;
+}
+
+void VpTransform::setMappingF(double xscale, double yscale, double xoffset, double yoffset)
+{
+    m_xscaleF = xscale;
+    m_yscaleF = yscale;
+    m_xoffsetF = xoffset;
+    m_yoffsetF = yoffset;
+
+    // Invert the mapping once; device to world then only multiplies.
+    m_xinvscaleF = (xscale != 0) ? (1.0 / xscale) : 0;
+    m_yinvscaleF = (yscale != 0) ? (1.0 / yscale) : 0;
+    m_xinvoffsetF = -xoffset * m_xinvscaleF;
+    m_yinvoffsetF = -yoffset * m_yinvscaleF;
+    m_xinvscale = (float) m_xinvscaleF;
+    m_yinvscale = (float) m_yinvscaleF;
+}
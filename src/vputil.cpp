@@ -28,8 +28,3 @@ VpUtil::VpUtil()
 {
     // Do nothing extra.
 }
-
-int VpUtil::round(double value)
-{
-    return ((int) ((value) < 0.0 ? (value) - 0.5 : (value) + 0.5));
-}
@@ -0,0 +1,162 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include Qt header files.
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+
+// Include QtVp header files.
+#include "vpkernels.h"
+
+Q_DECLARE_METATYPE(VpKernels::Isa)
+
+/**
+ * Benchmarks for the coordinate kernels. Each row runs a kernel with one
+ * instruction set; QBENCHMARK reports the time per iteration of
+ * <code>POINTS</code> pairs and the throughput is printed in points per
+ * second.
+ */
+class BenchVpKernels : public QObject
+{
+    Q_OBJECT
+
+  private:
+
+    // The number of (x,y) pairs transformed per iteration.
+    static const int POINTS = 1 << 16;
+
+    static void report(const char *kernel, qint64 points, qint64 nsecs)
+    {
+        if (nsecs > 0)
+            qDebug("%s, %s: %.1f Mpoints/s", kernel, QTest::currentDataTag(),
+                   (points * 1000.0) / nsecs);
+    }
+
+  private slots:
+
+    void initTestCase();
+    void cleanup();
+
+    void kernels_data();
+    void worldToDev();
+    void worldToDev_data() { kernels_data(); }
+    void devToWorld();
+    void devToWorld_data() { kernels_data(); }
+    void snapToGrid();
+    void snapToGrid_data() { kernels_data(); }
+
+  private:
+
+    QVector<int> m_src;
+    QVector<int> m_dst;
+};
+
+void BenchVpKernels::initTestCase()
+{
+    QRandomGenerator random(1);
+    m_src.resize(2 * POINTS);
+    m_dst.resize(2 * POINTS);
+    for (int i = 0; i < m_src.size(); i++)
+        m_src[i] = random.bounded(-100000, 100001);
+}
+
+void BenchVpKernels::cleanup()
+{
+    VpKernels::setIsa(VpKernels::getSupportedIsa());
+}
+
+void BenchVpKernels::kernels_data()
+{
+    QTest::addColumn<VpKernels::Isa>("isa");
+
+    QTest::newRow("scalar") << VpKernels::ISA_SCALAR;
+    QTest::newRow("sse2") << VpKernels::ISA_SSE2;
+    QTest::newRow("avx2") << VpKernels::ISA_AVX2;
+}
+
+void BenchVpKernels::worldToDev()
+{
+    QFETCH(VpKernels::Isa, isa);
+
+    if (isa > VpKernels::getSupportedIsa())
+        QSKIP("The instruction set is not supported by this CPU.");
+    VpKernels::setIsa(isa);
+
+    // Declare local variables.
+    QElapsedTimer timer;
+    qint64 points = 0;
+
+    timer.start();
+    QBENCHMARK {
+        VpKernels::worldToDev(m_src.constData(), m_dst.data(), POINTS, 0.37, -0.37, 411.5, 293.25);
+        points += POINTS;
+    }
+    report("worldToDev", points, timer.nsecsElapsed());
+}
+
+void BenchVpKernels::devToWorld()
+{
+    QFETCH(VpKernels::Isa, isa);
+
+    if (isa > VpKernels::getSupportedIsa())
+        QSKIP("The instruction set is not supported by this CPU.");
+    VpKernels::setIsa(isa);
+
+    // Declare local variables.
+    QElapsedTimer timer;
+    qint64 points = 0;
+
+    timer.start();
+    QBENCHMARK {
+        VpKernels::devToWorld(m_src.constData(), m_dst.data(), POINTS, 1.0 / 0.37, -1.0 / 0.37,
+                              -411.5 / 0.37, 293.25 / 0.37);
+        points += POINTS;
+    }
+    report("devToWorld", points, timer.nsecsElapsed());
+}
+
+void BenchVpKernels::snapToGrid()
+{
+    QFETCH(VpKernels::Isa, isa);
+
+    if (isa > VpKernels::getSupportedIsa())
+        QSKIP("The instruction set is not supported by this CPU.");
+    VpKernels::setIsa(isa);
+
+    // Declare local variables.
+    QElapsedTimer timer;
+    qint64 points = 0;
+
+    timer.start();
+    QBENCHMARK {
+        VpKernels::snapToGrid(m_src.constData(), m_dst.data(), POINTS, 7, 13, -3, 5);
+        points += POINTS;
+    }
+    report("snapToGrid", points, timer.nsecsElapsed());
+}
+
+QTEST_APPLESS_MAIN(BenchVpKernels)
+#include "bench_vpkernels.moc"
@@ -0,0 +1,8 @@
+TARGET = bench_vpkernels
+
+include(../tests.pri)
+
+# Benchmarks are run by hand, not by "make check".
+CONFIG -= testcase
+
+SOURCES += bench_vpkernels.cpp
@@ -0,0 +1,13 @@
+# Common settings for the QtVp tests. Each test builds the library sources
+# in, so the tests run without installing QtVp.
+
+QT += core gui widgets testlib
+
+CONFIG += testcase console c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += QTVP_LIBRARY
+
+include(../qtvp.pri)
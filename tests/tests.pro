@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS += tst_allocation \
+    tst_vpgridlayout \
+    tst_vpdisplaylist \
+    tst_vpspatialindex \
+    tst_vpkernels \
+    bench_vpkernels
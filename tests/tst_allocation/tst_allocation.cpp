@@ -0,0 +1,320 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include system header files.
+#include <climits>
+
+// Include Qt header files.
+#include <QtTest/QtTest>
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QPixmap>
+#include <QRegion>
+
+// Include QtVp header files.
+#include "vpgraphics2d.h"
+#include "vpruler.h"
+#include "vpgrid.h"
+#include "vpdisplaylist.h"
+
+// Allocations are counted only on the thread that asked for them, so the
+// platform's own threads do not disturb the counts.
+static thread_local bool g_counting = false;
+static thread_local int g_allocations = 0;
+
+#if defined(__GLIBC__)
+
+// Qt's containers allocate with malloc() rather than operator new, so the
+// malloc family is interposed. This is only done on glibc, where
+// operator new calls malloc() too; elsewhere the tests are skipped rather
+// than pass without counting anything.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size)
+{
+    if (g_counting)
+        g_allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if (g_counting)
+        g_allocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    if (g_counting)
+        g_allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+#define COUNTS_ALLOCATIONS
+
+#endif
+
+/**
+ * A widget that does the least painting any widget can do: it copies the
+ * damaged region from a pixmap. Its allocations are those Qt makes on
+ * every paint, which the QtVp widgets cannot avoid either.
+ */
+class BaselineWidget : public QWidget
+{
+  public:
+
+    BaselineWidget() : m_painter(NULL) { setMouseTracking(true); }
+    virtual ~BaselineWidget() { delete m_painter; }
+
+  protected:
+
+    void paintEvent(QPaintEvent *event)
+    {
+        qreal ratio = devicePixelRatio();
+        if (m_pixmap.size() != size() * ratio)
+        {
+            m_pixmap = QPixmap(size() * ratio);
+            m_pixmap.setDevicePixelRatio(ratio);
+            m_pixmap.fill(Qt::white);
+        }
+        if (m_painter == NULL)
+            m_painter = new QPainter();
+
+        m_painter->begin(this);
+        const QRegion &region = event->region();
+        for (QRegion::const_iterator it = region.begin(); it != region.end(); ++it)
+        {
+            const QRect &r = *it;
+            QRect source(QPoint(qRound(r.x() * ratio), qRound(r.y() * ratio)), r.size() * ratio);
+            m_painter->drawPixmap(r, m_pixmap, source);
+        }
+        m_painter->end();
+    }
+
+    void mouseMoveEvent(QMouseEvent *event)
+    {
+        event->accept();
+    }
+
+    QPixmap m_pixmap;
+    QPainter *m_painter;
+};
+
+class TestAllocation : public QObject
+{
+    Q_OBJECT
+
+  private:
+
+    /**
+     * Count the allocations made by repainting the region of a widget.
+     * The least count over several repaints is returned, so allocations
+     * made once, by caches warming up, are not counted.
+     */
+    static int countRepaint(QWidget *widget, const QRegion &region)
+    {
+        // Declare local variables.
+        int least = INT_MAX;
+
+        for (int i = 0; i < 5; i++)
+        {
+            g_allocations = 0;
+            g_counting = true;
+            widget->repaint(region);
+            g_counting = false;
+            least = qMin(least, g_allocations);
+        }
+        return least;
+    }
+
+    /**
+     * Count the allocations made by delivering mouse moves to a widget.
+     * The events are built before counting starts, so only their delivery
+     * and handling are counted.
+     */
+    static int countMoves(QWidget *widget, int count)
+    {
+        // Declare local variables.
+        int total = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            QPointF pos(20 + (i * 7) % 280, 20 + (i * 3) % 200);
+            QMouseEvent event(QEvent::MouseMove, pos, widget->mapToGlobal(pos.toPoint()),
+                              Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+            g_allocations = 0;
+            g_counting = true;
+            QCoreApplication::sendEvent(widget, &event);
+            g_counting = false;
+            total += g_allocations;
+        }
+        return total;
+    }
+
+    /**
+     * Give a view a grid with a reference marker and a few display list
+     * items, so painting and moves have work to do.
+     */
+    static void populate(VpGraphics2D *view)
+    {
+        VpGrid *grid = view->getGrid();
+        grid->setState(VpGrid::STATE_ON);
+        grid->setStyle(VpGrid::STYLE_DOT);
+        grid->setXSpacing(10);
+        grid->setYSpacing(10);
+        grid->setAdaptive(true);
+        grid->setReferenceState(VpGrid::REFSTATE_ON);
+
+        VpDisplayList *list = view->getDisplayList();
+        list->addLine(QPointF(-50, -50), QPointF(50, 50), 0);
+        list->addRect(QRectF(-20, -20, 40, 30), 0);
+        list->addMarker(QPointF(10, 10), 0);
+        list->addText(QPointF(-30, 20), "label", 0);
+    }
+
+    static void show(QWidget *widget, const QSize &size)
+    {
+        widget->resize(size);
+        widget->show();
+        QVERIFY(QTest::qWaitForWindowExposed(widget));
+
+        // Let the first paint build the backing stores and caches.
+        widget->repaint();
+        QCoreApplication::processEvents();
+    }
+
+  private slots:
+
+    void initTestCase();
+    void repaintUnchangedView_data();
+    void repaintUnchangedView();
+    void repaintUnchangedRuler_data();
+    void repaintUnchangedRuler();
+    void moveMouse_data();
+    void moveMouse();
+
+  private:
+
+    BaselineWidget m_baseline;
+};
+
+void TestAllocation::initTestCase()
+{
+#if !defined(COUNTS_ALLOCATIONS)
+    QSKIP("Allocations can only be counted on glibc.");
+#endif
+    show(&m_baseline, QSize(320, 240));
+}
+
+void TestAllocation::repaintUnchangedView_data()
+{
+    QTest::addColumn<QRegion>("region");
+
+    QTest::newRow("whole") << QRegion(0, 0, 320, 240);
+    QTest::newRow("rect") << QRegion(10, 10, 50, 40);
+    QTest::newRow("rects") << (QRegion(10, 10, 50, 40) + QRegion(200, 100, 30, 60));
+}
+
+void TestAllocation::repaintUnchangedView()
+{
+    QFETCH(QRegion, region);
+
+    // Draw the grid in one go so the view is complete after the first paint.
+    VpGraphics2D view;
+    view.setGridTimeBudget(0);
+    populate(&view);
+    show(&view, QSize(320, 240));
+
+    int expected = countRepaint(&m_baseline, region);
+    int actual = countRepaint(&view, region);
+    QVERIFY2(actual <= expected,
+             qPrintable(QString("%1 allocations, Qt alone makes %2").arg(actual).arg(expected)));
+}
+
+void TestAllocation::repaintUnchangedRuler_data()
+{
+    QTest::addColumn<QRegion>("region");
+
+    QTest::newRow("whole") << QRegion(0, 0, 320, RULER_BREADTH);
+    QTest::newRow("indicator") << QRegion(100, 0, 5, RULER_BREADTH);
+    QTest::newRow("indicators") << (QRegion(100, 0, 5, RULER_BREADTH) + QRegion(150, 0, 5, RULER_BREADTH));
+}
+
+void TestAllocation::repaintUnchangedRuler()
+{
+    QFETCH(QRegion, region);
+
+    VpRuler ruler(NULL, VpRuler::Horizontal);
+    show(&ruler, QSize(320, RULER_BREADTH));
+
+    int expected = countRepaint(&m_baseline, region);
+    int actual = countRepaint(&ruler, region);
+    QVERIFY2(actual <= expected,
+             qPrintable(QString("%1 allocations, Qt alone makes %2").arg(actual).arg(expected)));
+}
+
+void TestAllocation::moveMouse_data()
+{
+    QTest::addColumn<bool>("coalesced");
+
+    // Coalesced moves are queued for the next frame; the others are each
+    // processed at once: mapped, snapped and signalled.
+    QTest::newRow("coalesced") << true;
+    QTest::newRow("immediate") << false;
+}
+
+void TestAllocation::moveMouse()
+{
+    QFETCH(bool, coalesced);
+
+    VpGraphics2D view;
+    view.setGridTimeBudget(0);
+    view.setMouseMoveCoalesced(coalesced);
+    populate(&view);
+    show(&view, QSize(320, 240));
+
+    // Someone listens, so the signals are not skipped.
+    int signalled = 0;
+    connect(&view, &VpGraphics2D::pointChanged, [&signalled](const VpPoint &) { signalled++; });
+    connect(&view, &VpGraphics2D::mouseMovedTo,
+            [&signalled](const QPointF &, Qt::MouseButtons, Qt::KeyboardModifiers) { signalled++; });
+
+    // The first moves process at once and start the frame timer; the ones
+    // counted then arrive while it runs.
+    countMoves(&view, 2);
+    countMoves(&m_baseline, 2);
+
+    int expected = countMoves(&m_baseline, 100);
+    int actual = countMoves(&view, 100);
+    QVERIFY(signalled > 0);
+    QVERIFY2(actual <= expected,
+             qPrintable(QString("%1 allocations, Qt alone makes %2").arg(actual).arg(expected)));
+}
+
+QTEST_MAIN(TestAllocation)
+#include "tst_allocation.moc"
@@ -0,0 +1,5 @@
+TARGET = tst_allocation
+
+include(../tests.pri)
+
+SOURCES += tst_allocation.cpp
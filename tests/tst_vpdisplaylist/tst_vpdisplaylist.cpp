@@ -0,0 +1,378 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include Qt header files.
+#include <QtTest/QtTest>
+#include <QTransform>
+
+// Include QtVp header files.
+#include "vpdisplaylist.h"
+
+// Exposes the vertex pool, to check that compaction keeps the live items.
+class TestList : public VpDisplayList
+{
+  public:
+
+    int getPoolSize() const { return m_points.size(); }
+    int getGarbage() const { return m_garbage; }
+};
+
+// A zig-zag polyline of four vertices, distinct for each n.
+static QPolygonF zigzag(int n)
+{
+    QPolygonF points;
+    points << QPointF(n * 10, 0) << QPointF(n * 10 + 3, 5)
+           << QPointF(n * 10 + 6, 0) << QPointF(n * 10 + 9, 5);
+    return points;
+}
+
+class TestVpDisplayList : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void insertAndRemove();
+    void staleHandles();
+    void clearMakesHandlesStale();
+    void setPointsReusesPool();
+    void compaction();
+    void copyAndRelease();
+    void selectIntersecting();
+    void selectContained();
+    void pickTolerance();
+    void pickAnisotropic();
+    void pickNearestAndTopmost();
+};
+
+void TestVpDisplayList::insertAndRemove()
+{
+    VpDisplayList list;
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(10, 5), 0);
+    VpDisplayList::Handle rect = list.addRect(QRectF(20, 20, 5, 5), 0);
+    VpDisplayList::Handle text = list.addText(QPointF(-3, 4), "label", 0);
+
+    QCOMPARE(list.getCount(), 3);
+    QVERIFY(line != 0);
+    QVERIFY((line != rect) && (rect != text) && (line != text));
+    QCOMPARE(list.getType(line), VpDisplayList::ITEM_LINE);
+    QCOMPARE(list.getType(rect), VpDisplayList::ITEM_RECT);
+    QCOMPARE(list.getType(text), VpDisplayList::ITEM_TEXT);
+    QCOMPARE(list.getBounds(line), QRectF(0, 0, 10, 5));
+    QCOMPARE(list.getBounds(rect), QRectF(20, 20, 5, 5));
+    QCOMPARE(list.getBounds(text), QRectF(-3, 4, 0, 0));
+
+    // Too few vertices make no item.
+    QCOMPARE(list.addPolyline(QPolygonF() << QPointF(1, 1), 0), (VpDisplayList::Handle) 0);
+    QCOMPARE(list.addPolygon(QPolygonF() << QPointF(1, 1) << QPointF(2, 2), 0),
+             (VpDisplayList::Handle) 0);
+    QCOMPARE(list.getCount(), 3);
+
+    QVERIFY(list.remove(rect));
+    QCOMPARE(list.getCount(), 2);
+    QVERIFY(list.isValid(line));
+    QVERIFY(list.isValid(text));
+
+    // Only the remaining items are found.
+    QVector<VpDisplayList::Handle> found;
+    list.query(QRectF(-100, -100, 200, 200), &found);
+    QCOMPARE(found.size(), 2);
+    QVERIFY(found.contains(line));
+    QVERIFY(found.contains(text));
+}
+
+void TestVpDisplayList::staleHandles()
+{
+    VpDisplayList list;
+    VpDisplayList::Handle old = list.addMarker(QPointF(1, 2), 0);
+
+    QVERIFY(list.remove(old));
+    QVERIFY(! list.isValid(old));
+    QCOMPARE(list.getType(old), VpDisplayList::ITEM_NONE);
+    QCOMPARE(list.getBounds(old), QRectF());
+    QVERIFY(! list.remove(old));
+    QVERIFY(! list.setPoints(old, QPolygonF() << QPointF(3, 4)));
+    QVERIFY(! list.setItemStyle(old, 0));
+
+    // The new item takes the freed slot, but not the old handle.
+    VpDisplayList::Handle reuse = list.addMarker(QPointF(5, 6), 0);
+    QVERIFY(reuse != old);
+    QCOMPARE(reuse & 0xffffffff, old & 0xffffffff);
+    QVERIFY(list.isValid(reuse));
+    QVERIFY(! list.isValid(old));
+    QVERIFY(! list.remove(old));
+    QCOMPARE(list.getCount(), 1);
+    QCOMPARE(list.getBounds(reuse), QRectF(5, 6, 0, 0));
+
+    // Handles never seen are rejected too.
+    QVERIFY(! list.isValid(0));
+    QVERIFY(! list.isValid(((VpDisplayList::Handle) 1 << 32) | 99));
+}
+
+void TestVpDisplayList::clearMakesHandlesStale()
+{
+    VpDisplayList list;
+    VpDisplayList::Handle a = list.addLine(QPointF(0, 0), QPointF(1, 1), 0);
+    VpDisplayList::Handle b = list.addLine(QPointF(2, 2), QPointF(3, 3), 0);
+
+    list.clear();
+    QCOMPARE(list.getCount(), 0);
+    QVERIFY(! list.isValid(a));
+    QVERIFY(! list.isValid(b));
+
+    VpDisplayList::Handle c = list.addLine(QPointF(4, 4), QPointF(5, 5), 0);
+    QVERIFY((c != a) && (c != b));
+    QVERIFY(! list.isValid(a));
+    QVERIFY(! list.isValid(b));
+
+    QVector<VpDisplayList::Handle> found;
+    list.query(QRectF(-10, -10, 20, 20), &found);
+    QCOMPARE(found.size(), 1);
+    QCOMPARE(found.at(0), c);
+}
+
+void TestVpDisplayList::setPointsReusesPool()
+{
+    TestList list;
+    VpDisplayList::Handle item = list.addPolyline(zigzag(0), 0);
+    int size = list.getPoolSize();
+
+    // Fewer vertices fit in place and leave garbage.
+    QVERIFY(list.setPoints(item, QPolygonF() << QPointF(-1, -2) << QPointF(7, 8)));
+    QCOMPARE(list.getPoolSize(), size);
+    QCOMPARE(list.getGarbage(), 2);
+    QCOMPARE(list.getBounds(item), QRectF(QPointF(-1, -2), QPointF(7, 8)));
+
+    // More vertices move to the end of the pool.
+    QVERIFY(list.setPoints(item, QPolygonF(zigzag(1) + zigzag(2))));
+    QCOMPARE(list.getPoolSize(), size + 8);
+    QCOMPARE(list.getBounds(item), QRectF(QPointF(10, 0), QPointF(29, 5)));
+
+    // The vertex count must suit the type.
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(1, 1), 0);
+    QVERIFY(! list.setPoints(line, zigzag(3)));
+    QCOMPARE(list.getBounds(line), QRectF(0, 0, 1, 1));
+}
+
+void TestVpDisplayList::compaction()
+{
+    TestList list;
+    QVector<VpDisplayList::Handle> items;
+    const int count = 600;
+
+    for (int n = 0; n < count; n++)
+        items.append(list.addPolyline(zigzag(n), 0));
+    QCOMPARE(list.getPoolSize(), count * 4);
+
+    // Remove two items in three; the pool is compacted along the way.
+    bool compacted = false;
+    for (int n = 0; n < count; n++)
+    {
+        if ((n % 3) != 0)
+        {
+            QVERIFY(list.remove(items.at(n)));
+            if (list.getGarbage() == 0)
+                compacted = true;
+        }
+    }
+    QVERIFY(compacted);
+    QCOMPARE(list.getPoolSize() - list.getGarbage(), (count / 3) * 4);
+    QVERIFY(list.getPoolSize() < count * 4);
+
+    // The surviving items keep their handles and their geometry: each is
+    // selected by a rectangle that meets only its own second segment.
+    for (int n = 0; n < count; n++)
+    {
+        if ((n % 3) != 0)
+        {
+            QVERIFY(! list.isValid(items.at(n)));
+            continue;
+        }
+        QVERIFY(list.isValid(items.at(n)));
+        QCOMPARE(list.getBounds(items.at(n)), zigzag(n).boundingRect());
+
+        QVector<VpDisplayList::Handle> found;
+        list.select(QRectF(n * 10 + 4.4, 2, 0.2, 1), false, &found);
+        QCOMPARE(found.size(), 1);
+        QCOMPARE(found.at(0), items.at(n));
+    }
+}
+
+void TestVpDisplayList::copyAndRelease()
+{
+    VpDisplayList list;
+    VpDisplayList snapshot;
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(10, 0), 0);
+
+    snapshot.copy(list);
+    QCOMPARE(snapshot.getCount(), 1);
+    QVERIFY(snapshot.isValid(line));
+
+    // Releasing the snapshot leaves it empty and the original intact.
+    snapshot.release();
+    QCOMPARE(snapshot.getCount(), 0);
+    QVERIFY(! snapshot.isValid(line));
+    QVERIFY(list.isValid(line));
+    QCOMPARE(list.getBounds(line), QRectF(0, 0, 10, 0));
+
+    // A released list can be copied into again.
+    list.addMarker(QPointF(5, 5), 0);
+    snapshot.copy(list);
+    QCOMPARE(snapshot.getCount(), 2);
+}
+
+// Select with a rectangle and return the handles found.
+static QVector<VpDisplayList::Handle> selected(VpDisplayList &list, const QRectF &rect,
+                                              bool contained)
+{
+    QVector<VpDisplayList::Handle> items;
+    list.select(rect, contained, &items);
+    return items;
+}
+
+void TestVpDisplayList::selectIntersecting()
+{
+    VpDisplayList list;
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(10, 10), 0);
+    VpDisplayList::Handle triangle = list.addPolygon(
+        QPolygonF() << QPointF(0, 20) << QPointF(20, 20) << QPointF(10, 40), 0);
+    VpDisplayList::Handle rect = list.addRect(QRectF(30, 0, 10, 10), 0);
+    QVector<VpDisplayList::Handle> none;
+
+    // The bounding box of the diagonal meets this corner, its geometry
+    // does not.
+    QVector<VpDisplayList::Handle> found;
+    list.query(QRectF(7, 0, 3, 2), &found);
+    QCOMPARE(found, QVector<VpDisplayList::Handle>() << line);
+    QCOMPARE(selected(list, QRectF(7, 0, 3, 2), false), none);
+    QCOMPARE(selected(list, QRectF(1, 1, 1, 1), false), QVector<VpDisplayList::Handle>() << line);
+
+    // A polygon enclosing the rectangle meets it, though no edge does.
+    QCOMPARE(selected(list, QRectF(9, 25, 2, 2), false), QVector<VpDisplayList::Handle>() << triangle);
+
+    // Rectangles are areas.
+    QCOMPARE(selected(list, QRectF(35, 5, 1, 1), false), QVector<VpDisplayList::Handle>() << rect);
+
+    // The rectangle may be given corner to corner in any order.
+    QCOMPARE(selected(list, QRectF(2, 2, -1, -1), false), QVector<VpDisplayList::Handle>() << line);
+}
+
+void TestVpDisplayList::selectContained()
+{
+    VpDisplayList list;
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(10, 10), 0);
+    VpDisplayList::Handle triangle = list.addPolygon(
+        QPolygonF() << QPointF(0, 20) << QPointF(20, 20) << QPointF(10, 40), 0);
+    VpDisplayList::Handle marker = list.addMarker(QPointF(50, 50), 0);
+    QVector<VpDisplayList::Handle> none;
+
+    // Items must lie entirely within the rectangle, edges included.
+    QCOMPARE(selected(list, QRectF(-1, -1, 12, 12), true), QVector<VpDisplayList::Handle>() << line);
+    QCOMPARE(selected(list, QRectF(0, 0, 10, 10), true), QVector<VpDisplayList::Handle>() << line);
+    QCOMPARE(selected(list, QRectF(-1, -1, 6, 6), true), none);
+    QCOMPARE(selected(list, QRectF(-1, -1, 6, 6), false), QVector<VpDisplayList::Handle>() << line);
+
+    // Inside a polygon is not containing it.
+    QCOMPARE(selected(list, QRectF(9, 25, 2, 2), true), none);
+    QCOMPARE(selected(list, QRectF(0, 20, 20, 20), true), QVector<VpDisplayList::Handle>() << triangle);
+
+    // Markers are contained by their anchor, whichever way the band is drawn.
+    QCOMPARE(selected(list, QRectF(45, 45, 5, 5), true), QVector<VpDisplayList::Handle>() << marker);
+    QCOMPARE(selected(list, QRectF(50, 50, -5, -5), true), QVector<VpDisplayList::Handle>() << marker);
+
+    QCOMPARE(selected(list, QRectF(-100, -100, 200, 200), true).size(), 3);
+}
+
+void TestVpDisplayList::pickTolerance()
+{
+    VpDisplayList list;
+    // Two pixels per world unit, with y pointing up.
+    QTransform matrix(2, 0, 0, -2, 100, 100);
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(10, 0), 0);
+    VpDisplayList::Handle marker = list.addMarker(QPointF(30, 0), 0);
+    VpDisplayList::Handle text = list.addText(QPointF(60, 0), "label", 0);
+
+    // Three world units off the line are six pixels, whichever side.
+    QCOMPARE(list.pick(QPointF(5, 3), 6, matrix), line);
+    QCOMPARE(list.pick(QPointF(5, -3), 6, matrix), line);
+    QCOMPARE(list.pick(QPointF(5, 3), 5, matrix), (VpDisplayList::Handle) 0);
+
+    // Beyond an end, the distance is to the end point: 3 by 4 units.
+    QCOMPARE(list.pick(QPointF(13, 4), 10, matrix), line);
+    QCOMPARE(list.pick(QPointF(13, 4), 9, matrix), (VpDisplayList::Handle) 0);
+
+    // A marker is measured from its edge, half its size from the anchor.
+    QCOMPARE(list.pick(QPointF(30, 2), 2, matrix), marker);
+    QCOMPARE(list.pick(QPointF(30, 2), 1, matrix), (VpDisplayList::Handle) 0);
+    QCOMPARE(list.pick(QPointF(30.5, 0.5), 0, matrix), marker);
+
+    // Text is measured to its anchor.
+    QCOMPARE(list.pick(QPointF(60, 1), 2, matrix), text);
+    QCOMPARE(list.pick(QPointF(60, 1), 1, matrix), (VpDisplayList::Handle) 0);
+
+    // No tolerance, or no mapping, finds nothing.
+    QCOMPARE(list.pick(QPointF(5, 0), -1, matrix), (VpDisplayList::Handle) 0);
+    QCOMPARE(list.pick(QPointF(5, 0), 6, QTransform(0, 0, 0, 0, 0, 0)), (VpDisplayList::Handle) 0);
+}
+
+void TestVpDisplayList::pickAnisotropic()
+{
+    VpDisplayList list;
+    // One pixel per unit across, four up.
+    QTransform matrix(1, 0, 0, 4, 0, 0);
+    VpDisplayList::Handle line = list.addLine(QPointF(0, 0), QPointF(10, 0), 0);
+
+    QCOMPARE(list.pick(QPointF(12, 0), 2, matrix), line);
+    QCOMPARE(list.pick(QPointF(5, 2), 2, matrix), (VpDisplayList::Handle) 0);
+    QCOMPARE(list.pick(QPointF(5, 2), 8, matrix), line);
+    QCOMPARE(list.pick(QPointF(5, 0.5), 2, matrix), line);
+}
+
+void TestVpDisplayList::pickNearestAndTopmost()
+{
+    VpDisplayList list;
+    QTransform matrix;
+    VpDisplayList::Handle nearer = list.addLine(QPointF(0, 0), QPointF(10, 0), 0);
+    VpDisplayList::Handle farther = list.addLine(QPointF(0, 3), QPointF(10, 3), 0);
+
+    // The nearest item wins, whatever the order.
+    QCOMPARE(list.pick(QPointF(5, 1), 5, matrix), nearer);
+    QCOMPARE(list.pick(QPointF(5, 2), 5, matrix), farther);
+
+    // Inside an area the distance is zero; of equal items, the one drawn
+    // last wins.
+    VpDisplayList::Handle lower = list.addRect(QRectF(20, 0, 10, 10), 0);
+    VpDisplayList::Handle upper = list.addRect(QRectF(20, 0, 10, 10), 0);
+    QCOMPARE(list.pick(QPointF(25, 5), 0, matrix), upper);
+    QVERIFY(list.remove(upper));
+    QCOMPARE(list.pick(QPointF(25, 5), 0, matrix), lower);
+
+    VpDisplayList::Handle triangle = list.addPolygon(
+        QPolygonF() << QPointF(40, 0) << QPointF(60, 0) << QPointF(50, 20), 0);
+    QCOMPARE(list.pick(QPointF(50, 5), 0, matrix), triangle);
+    QCOMPARE(list.pick(QPointF(50, 21), 0, matrix), (VpDisplayList::Handle) 0);
+    QCOMPARE(list.pick(QPointF(50, 21), 1, matrix), triangle);
+}
+
+QTEST_MAIN(TestVpDisplayList)
+#include "tst_vpdisplaylist.moc"
@@ -0,0 +1,5 @@
+TARGET = tst_vpdisplaylist
+
+include(../tests.pri)
+
+SOURCES += tst_vpdisplaylist.cpp
@@ -0,0 +1,201 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include system header files.
+#include <climits>
+
+// Include Qt header files.
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+
+// Include QtVp header files.
+#include "vpgridlayout.h"
+#include "vputil.h"
+
+// The layout as drawGridLevel() used to compute it: snap the extent with
+// VpGrid::snapToGrid() at the display spacing, then count the primitives
+// by stepping through it.
+struct Reference
+{
+    int m_xll, m_yll, m_xur, m_yur;
+    int m_xnum, m_ynum;
+};
+
+static int snap(int value, int spacing, int alignment)
+{
+    return VpUtil::round(((double)(value - alignment))/((double)(spacing))) * spacing + alignment;
+}
+
+static Reference referenceLayout(int wxmin, int wymin, int wxmax, int wymax,
+                                 int dx, int dy, int xalignment, int yalignment,
+                                 VpGrid::Style style)
+{
+    // Declare local variables.
+    Reference ref;
+    int i, j, xnum = 0, ynum = 0;
+    int halfdx = dx >> 1;
+    int halfdy = dy >> 1;
+
+    if (style == VpGrid::STYLE_DOT)
+    {
+        ref.m_xll = wxmin + halfdx;
+        ref.m_yll = wymin + halfdy;
+        ref.m_xur = wxmax - halfdx;
+        ref.m_yur = wymax - halfdy;
+    } else
+    {
+        ref.m_xll = wxmin - halfdx;
+        ref.m_yll = wymin - halfdy;
+        ref.m_xur = wxmax + halfdx;
+        ref.m_yur = wymax + halfdy;
+    }
+
+    ref.m_xll = snap(ref.m_xll, dx, xalignment);
+    ref.m_yll = snap(ref.m_yll, dy, yalignment);
+    ref.m_xur = snap(ref.m_xur, dx, xalignment);
+    ref.m_yur = snap(ref.m_yur, dy, yalignment);
+
+    for (i = ref.m_xll; i <= ref.m_xur; i = i + dx)
+        xnum++;
+    for (j = ref.m_yll; j <= ref.m_yur; j = j + dy)
+        ynum++;
+
+    switch (style)
+    {
+        case VpGrid::STYLE_DOT:
+            ref.m_xnum = xnum;
+            ref.m_ynum = ynum - 1;
+            break;
+        case VpGrid::STYLE_CROSS:
+            ref.m_xnum = xnum - 1;
+            ref.m_ynum = ynum - 1;
+            break;
+        default:
+            ref.m_xnum = xnum;
+            ref.m_ynum = ynum;
+            break;
+    }
+    return ref;
+}
+
+class TestVpGridLayout : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void matchesCountingLoops_data();
+    void matchesCountingLoops();
+    void maximumExtent_data();
+    void maximumExtent();
+    void isLayoutOf();
+};
+
+void TestVpGridLayout::matchesCountingLoops_data()
+{
+    QTest::addColumn<int>("style");
+
+    QTest::newRow("line") << (int) VpGrid::STYLE_LINE;
+    QTest::newRow("dot") << (int) VpGrid::STYLE_DOT;
+    QTest::newRow("cross") << (int) VpGrid::STYLE_CROSS;
+}
+
+void TestVpGridLayout::matchesCountingLoops()
+{
+    QFETCH(int, style);
+
+    // Declare local variables.
+    VpGridLayout layout;
+    Reference ref;
+
+    // A fixed seed keeps failures reproducible.
+    QRandomGenerator random(11);
+    for (int n = 0; n < 20000; n++)
+    {
+        int wxmin = random.bounded(-100000, 100001);
+        int wymin = random.bounded(-100000, 100001);
+        int wxmax = wxmin + random.bounded(100001);
+        int wymax = wymin + random.bounded(100001);
+        int dx = random.bounded(1, 1001);
+        int dy = random.bounded(1, 1001);
+        int xalignment = random.bounded(-500, 501);
+        int yalignment = random.bounded(-500, 501);
+
+        layout.compute(wxmin, wymin, wxmax, wymax, dx, dy, xalignment, yalignment,
+                       (VpGrid::Style) style);
+        ref = referenceLayout(wxmin, wymin, wxmax, wymax, dx, dy, xalignment, yalignment,
+                              (VpGrid::Style) style);
+
+        QCOMPARE(layout.getXll(), ref.m_xll);
+        QCOMPARE(layout.getYll(), ref.m_yll);
+        QCOMPARE(layout.getXur(), ref.m_xur);
+        QCOMPARE(layout.getYur(), ref.m_yur);
+        QCOMPARE(layout.getXnum(), ref.m_xnum);
+        QCOMPARE(layout.getYnum(), ref.m_ynum);
+    }
+}
+
+void TestVpGridLayout::maximumExtent_data()
+{
+    matchesCountingLoops_data();
+}
+
+void TestVpGridLayout::maximumExtent()
+{
+    QFETCH(int, style);
+
+    // The counting loops overflow here; the layout stays in the int range
+    // and keeps whole grid steps between its bounds.
+    VpGridLayout layout;
+    layout.compute(INT_MIN, INT_MIN, INT_MAX, INT_MAX, 7, 1000, 3, -2,
+                   (VpGrid::Style) style);
+
+    QVERIFY(layout.getXll() <= layout.getXur());
+    QVERIFY(layout.getYll() <= layout.getYur());
+    QCOMPARE(((qint64) layout.getXll() - 3) % 7, (qint64) 0);
+    QCOMPARE(((qint64) layout.getXur() - layout.getXll()) % 7, (qint64) 0);
+    QCOMPARE(((qint64) layout.getYur() - layout.getYll()) % 1000, (qint64) 0);
+
+    // The positions counted span the trimmed extent.
+    qint64 xpositions = ((qint64) layout.getXur() - layout.getXll()) / 7 + 1;
+    qint64 ypositions = ((qint64) layout.getYur() - layout.getYll()) / 1000 + 1;
+    int xextra = (style == VpGrid::STYLE_CROSS) ? -1 : 0;
+    int yextra = (style == VpGrid::STYLE_LINE) ? 0 : -1;
+    QCOMPARE((qint64) layout.getXnum(), xpositions + xextra);
+    QCOMPARE((qint64) layout.getYnum(), ypositions + yextra);
+}
+
+void TestVpGridLayout::isLayoutOf()
+{
+    VpGridLayout layout;
+    QVERIFY(! layout.isLayoutOf(0, 0, 0, 0, 1, 1, 0, 0, VpGrid::STYLE_UNKNOWN));
+
+    layout.compute(-10, -20, 30, 40, 5, 6, 1, 2, VpGrid::STYLE_DOT);
+    QVERIFY(layout.isLayoutOf(-10, -20, 30, 40, 5, 6, 1, 2, VpGrid::STYLE_DOT));
+    QVERIFY(! layout.isLayoutOf(-10, -20, 30, 40, 5, 6, 1, 2, VpGrid::STYLE_LINE));
+    QVERIFY(! layout.isLayoutOf(-10, -20, 30, 41, 5, 6, 1, 2, VpGrid::STYLE_DOT));
+    QVERIFY(! layout.isLayoutOf(-10, -20, 30, 40, 5, 6, 0, 2, VpGrid::STYLE_DOT));
+}
+
+QTEST_APPLESS_MAIN(TestVpGridLayout)
+#include "tst_vpgridlayout.moc"
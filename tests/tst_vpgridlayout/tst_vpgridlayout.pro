@@ -0,0 +1,5 @@
+TARGET = tst_vpgridlayout
+
+include(../tests.pri)
+
+SOURCES += tst_vpgridlayout.cpp
@@ -0,0 +1,223 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include Qt header files.
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <QTransform>
+#include <QVector>
+
+// Include QtVp header files.
+#include "vpkernels.h"
+#include "vputil.h"
+
+Q_DECLARE_METATYPE(VpKernels::Isa)
+
+class TestVpKernels : public QObject
+{
+    Q_OBJECT
+
+  private:
+
+    // The kernels under test.
+    enum Kernel { WORLD_TO_DEV, DEV_TO_WORLD, SNAP_TO_GRID };
+
+    /**
+     * Run a kernel over the source pairs with the specified instruction set.
+     * The parameters are, in order, the x and y scale (or spacing) and the
+     * x and y offset (or alignment).
+     */
+    static QVector<int> run(Kernel kernel, VpKernels::Isa isa, const QVector<int> &src,
+                            double p0, double p1, double p2, double p3)
+    {
+        QVector<int> dst(src.size());
+        int count = src.size() / 2;
+
+        VpKernels::setIsa(isa);
+        switch (kernel)
+        {
+            case WORLD_TO_DEV:
+                VpKernels::worldToDev(src.constData(), dst.data(), count, p0, p1, p2, p3);
+                break;
+            case DEV_TO_WORLD:
+                VpKernels::devToWorld(src.constData(), dst.data(), count, p0, p1, p2, p3);
+                break;
+            case SNAP_TO_GRID:
+                VpKernels::snapToGrid(src.constData(), dst.data(), count,
+                                      (int) p0, (int) p1, (int) p2, (int) p3);
+                break;
+        }
+        VpKernels::setIsa(VpKernels::getSupportedIsa());
+        return dst;
+    }
+
+    QVector<int> randomPairs(int count, int range)
+    {
+        QVector<int> src(2 * count);
+        for (int i = 0; i < src.size(); i++)
+            src[i] = m_random.bounded(-range, range + 1);
+        return src;
+    }
+
+    void compareWithScalar(Kernel kernel, double p0, double p1, double p2, double p3, int range);
+
+  private slots:
+
+    void init();
+    void cleanupTestCase();
+
+    void kernels_data();
+    void worldToDev();
+    void worldToDev_data() { kernels_data(); }
+    void devToWorld();
+    void devToWorld_data() { kernels_data(); }
+    void snapToGrid();
+    void snapToGrid_data() { kernels_data(); }
+    void inPlace();
+    void inPlace_data() { kernels_data(); }
+    void matchesMatrix();
+    void matchesMatrix_data() { kernels_data(); }
+    void setIsa();
+
+  private:
+
+    QRandomGenerator m_random;
+};
+
+void TestVpKernels::init()
+{
+    // A fixed seed keeps failures reproducible.
+    m_random.seed(2);
+}
+
+void TestVpKernels::cleanupTestCase()
+{
+    VpKernels::setIsa(VpKernels::getSupportedIsa());
+}
+
+void TestVpKernels::kernels_data()
+{
+    QTest::addColumn<VpKernels::Isa>("isa");
+
+    QTest::newRow("scalar") << VpKernels::ISA_SCALAR;
+    QTest::newRow("sse2") << VpKernels::ISA_SSE2;
+    QTest::newRow("avx2") << VpKernels::ISA_AVX2;
+}
+
+void TestVpKernels::compareWithScalar(Kernel kernel, double p0, double p1, double p2, double p3,
+                                      int range)
+{
+    QFETCH(VpKernels::Isa, isa);
+
+    if (isa > VpKernels::getSupportedIsa())
+        QSKIP("The instruction set is not supported by this CPU.");
+
+    // Cover the vector widths and every length of tail after them.
+    static const int counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1001 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        QVector<int> src = randomPairs(counts[i], range);
+        QVector<int> expected = run(kernel, VpKernels::ISA_SCALAR, src, p0, p1, p2, p3);
+        QVector<int> actual = run(kernel, isa, src, p0, p1, p2, p3);
+        QCOMPARE(actual, expected);
+    }
+}
+
+void TestVpKernels::worldToDev()
+{
+    compareWithScalar(WORLD_TO_DEV, 0.37, -0.37, 411.5, 293.25, 1000000);
+    compareWithScalar(WORLD_TO_DEV, 3.0, -2.5, -17.0, 1024.0, 100000);
+    compareWithScalar(WORLD_TO_DEV, 0.001, -0.001, 0.5, -0.5, 100000000);
+}
+
+void TestVpKernels::devToWorld()
+{
+    compareWithScalar(DEV_TO_WORLD, 1.0 / 0.37, -1.0 / 0.37, -411.5 / 0.37, 293.25 / 0.37, 4000);
+    compareWithScalar(DEV_TO_WORLD, 1.0 / 3.0, -1.0 / 2.5, 17.0 / 3.0, 1024.0 / 2.5, 4000);
+    compareWithScalar(DEV_TO_WORLD, 1000.0, -1000.0, -500.0, -500.0, 4000);
+}
+
+void TestVpKernels::snapToGrid()
+{
+    compareWithScalar(SNAP_TO_GRID, 10, 10, 0, 0, 1000000);
+    compareWithScalar(SNAP_TO_GRID, 7, 13, -3, 5, 1000000);
+    compareWithScalar(SNAP_TO_GRID, 1, 1000, 0, 499, 100000000);
+}
+
+void TestVpKernels::inPlace()
+{
+    QFETCH(VpKernels::Isa, isa);
+
+    if (isa > VpKernels::getSupportedIsa())
+        QSKIP("The instruction set is not supported by this CPU.");
+
+    // Source and destination may be the same array.
+    QVector<int> src = randomPairs(37, 100000);
+    QVector<int> expected = run(WORLD_TO_DEV, isa, src, 0.37, -0.37, 411.5, 293.25);
+    VpKernels::setIsa(isa);
+    VpKernels::worldToDev(src.constData(), src.data(), src.size() / 2, 0.37, -0.37, 411.5, 293.25);
+    VpKernels::setIsa(VpKernels::getSupportedIsa());
+    QCOMPARE(src, expected);
+}
+
+void TestVpKernels::matchesMatrix()
+{
+    QFETCH(VpKernels::Isa, isa);
+
+    if (isa > VpKernels::getSupportedIsa())
+        QSKIP("The instruction set is not supported by this CPU.");
+
+    // Integer coordinates map exactly as the matrices painting and picking
+    // use, rounded.
+    QTransform worldToDev(0.37, 0, 0, -0.37, 411.5, 293.25);
+    QTransform devToWorld = worldToDev.inverted();
+    QVector<int> src = randomPairs(1001, 100000);
+    QVector<int> dev = run(WORLD_TO_DEV, isa, src, worldToDev.m11(), worldToDev.m22(),
+                           worldToDev.dx(), worldToDev.dy());
+    QVector<int> world = run(DEV_TO_WORLD, isa, src, devToWorld.m11(), devToWorld.m22(),
+                             devToWorld.dx(), devToWorld.dy());
+    for (int i = 0; i < src.size(); i += 2)
+    {
+        qreal x, y;
+        worldToDev.map((qreal) src.at(i), (qreal) src.at(i + 1), &x, &y);
+        QCOMPARE(dev.at(i), VpUtil::round(x));
+        QCOMPARE(dev.at(i + 1), VpUtil::round(y));
+        devToWorld.map((qreal) src.at(i), (qreal) src.at(i + 1), &x, &y);
+        QCOMPARE(world.at(i), VpUtil::round(x));
+        QCOMPARE(world.at(i + 1), VpUtil::round(y));
+    }
+}
+
+void TestVpKernels::setIsa()
+{
+    // An unsupported instruction set falls back to the best supported one.
+    VpKernels::Isa supported = VpKernels::getSupportedIsa();
+    VpKernels::setIsa(VpKernels::ISA_AVX2);
+    QCOMPARE(VpKernels::getIsa(), supported);
+    VpKernels::setIsa(VpKernels::ISA_SCALAR);
+    QCOMPARE(VpKernels::getIsa(), VpKernels::ISA_SCALAR);
+    VpKernels::setIsa(supported);
+}
+
+QTEST_APPLESS_MAIN(TestVpKernels)
+#include "tst_vpkernels.moc"
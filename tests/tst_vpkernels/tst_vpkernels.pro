@@ -0,0 +1,5 @@
+TARGET = tst_vpkernels
+
+include(../tests.pri)
+
+SOURCES += tst_vpkernels.cpp
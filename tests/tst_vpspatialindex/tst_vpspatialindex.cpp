@@ -0,0 +1,256 @@
+// COPYRIGHT_BEGIN
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Wizzer Works
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// COPYRIGHT_END
+
+// Include system header files.
+#include <algorithm>
+
+// Include Qt header files.
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+
+// Include QtVp header files.
+#include "vpspatialindex.h"
+
+// A random box within [-1000, 1000]; one in eight is a point.
+static VpSpatialIndex::Entry randomBox(QRandomGenerator &random, int id)
+{
+    VpSpatialIndex::Entry entry;
+    entry.m_xmin = random.bounded(-1000, 1001);
+    entry.m_ymin = random.bounded(-1000, 1001);
+    entry.m_xmax = entry.m_xmin;
+    entry.m_ymax = entry.m_ymin;
+    if (random.bounded(8) != 0)
+    {
+        entry.m_xmax += random.bounded(100) + random.bounded(100) / 100.0;
+        entry.m_ymax += random.bounded(100) + random.bounded(100) / 100.0;
+    }
+    entry.m_id = id;
+    return entry;
+}
+
+// The ids found by testing every box, sorted.
+static QVector<int> bruteForce(const QVector<VpSpatialIndex::Entry> &items,
+                               const QRectF &rect, bool contained)
+{
+    QVector<int> ids;
+    QRectF r = rect.normalized();
+    for (int i = 0; i < items.size(); i++)
+    {
+        const VpSpatialIndex::Entry &e = items.at(i);
+        bool meets = (e.m_xmax >= r.left()) && (e.m_xmin <= r.right()) &&
+                     (e.m_ymax >= r.top()) && (e.m_ymin <= r.bottom());
+        bool within = (e.m_xmin >= r.left()) && (e.m_xmax <= r.right()) &&
+                      (e.m_ymin >= r.top()) && (e.m_ymax <= r.bottom());
+        if (contained ? within : meets)
+            ids.append(e.m_id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static QVector<int> sorted(QVector<int> ids)
+{
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Check every kind of query against the brute force answer.
+static bool matchesBruteForce(QRandomGenerator &random, const VpSpatialIndex &index,
+                              const QVector<VpSpatialIndex::Entry> &items, int queries)
+{
+    for (int q = 0; q < queries; q++)
+    {
+        double x = random.bounded(-1100, 1101);
+        double y = random.bounded(-1100, 1101);
+        double w = random.bounded(-300, 300);
+        double h = random.bounded(-300, 300);
+        QRectF rect(x, y, w, h);
+        QVector<int> ids;
+
+        index.query(rect, &ids);
+        if (sorted(ids) != bruteForce(items, rect, false))
+            return false;
+
+        ids.resize(0);
+        index.queryContained(rect, &ids);
+        if (sorted(ids) != bruteForce(items, rect, true))
+            return false;
+
+        ids.resize(0);
+        index.query(QPointF(x, y), &ids);
+        if (sorted(ids) != bruteForce(items, QRectF(x, y, 0, 0), false))
+            return false;
+    }
+    return true;
+}
+
+class TestVpSpatialIndex : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void empty();
+    void closedBoxes();
+    void insertAndRemove();
+    void loadThenUpdate();
+};
+
+void TestVpSpatialIndex::empty()
+{
+    VpSpatialIndex index;
+    QVector<int> ids;
+
+    index.query(QRectF(-1, -1, 2, 2), &ids);
+    QVERIFY(ids.isEmpty());
+    QCOMPARE(index.getCount(), 0);
+    QVERIFY(index.getBounds().isNull());
+    QVERIFY(! index.remove(1, 0, 0, 1, 1));
+}
+
+void TestVpSpatialIndex::closedBoxes()
+{
+    VpSpatialIndex index;
+    QVector<int> ids;
+
+    // Touching on an edge, or at a point, counts as meeting.
+    index.insert(1, 0, 0, 10, 10);
+    index.insert(2, 5, 5, 5, 5);
+    index.query(QRectF(10, 10, 5, 5), &ids);
+    QCOMPARE(ids, QVector<int>() << 1);
+
+    ids.resize(0);
+    index.query(QPointF(5, 5), &ids);
+    QCOMPARE(sorted(ids), QVector<int>() << 1 << 2);
+
+    ids.resize(0);
+    index.queryContained(QRectF(0, 0, 10, 10), &ids);
+    QCOMPARE(sorted(ids), QVector<int>() << 1 << 2);
+}
+
+void TestVpSpatialIndex::insertAndRemove()
+{
+    VpSpatialIndex index;
+    QVector<VpSpatialIndex::Entry> items;
+    int next = 0;
+
+    // A fixed seed keeps failures reproducible.
+    QRandomGenerator random(15);
+
+    // Grow the tree through several levels of splits.
+    for (int i = 0; i < 3000; i++)
+    {
+        VpSpatialIndex::Entry entry = randomBox(random, next++);
+        index.insert(entry.m_id, entry.m_xmin, entry.m_ymin, entry.m_xmax, entry.m_ymax);
+        items.append(entry);
+    }
+    QCOMPARE(index.getCount(), items.size());
+    QVERIFY(matchesBruteForce(random, index, items, 200));
+
+    // Churn: remove and insert at random, so nodes underflow and are
+    // reinserted while new items arrive.
+    for (int round = 0; round < 10; round++)
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            if (! items.isEmpty() && (random.bounded(3) != 0))
+            {
+                int k = random.bounded(items.size());
+                VpSpatialIndex::Entry entry = items.at(k);
+                QVERIFY(index.remove(entry.m_id, entry.m_xmin, entry.m_ymin,
+                                     entry.m_xmax, entry.m_ymax));
+                QVERIFY(! index.remove(entry.m_id, entry.m_xmin, entry.m_ymin,
+                                       entry.m_xmax, entry.m_ymax));
+                items.remove(k);
+            } else
+            {
+                VpSpatialIndex::Entry entry = randomBox(random, next++);
+                index.insert(entry.m_id, entry.m_xmin, entry.m_ymin, entry.m_xmax, entry.m_ymax);
+                items.append(entry);
+            }
+        }
+        QCOMPARE(index.getCount(), items.size());
+        QVERIFY(matchesBruteForce(random, index, items, 100));
+    }
+
+    // Empty the tree entirely.
+    while (! items.isEmpty())
+    {
+        VpSpatialIndex::Entry entry = items.last();
+        QVERIFY(index.remove(entry.m_id, entry.m_xmin, entry.m_ymin, entry.m_xmax, entry.m_ymax));
+        items.removeLast();
+    }
+    QCOMPARE(index.getCount(), 0);
+    QVERIFY(matchesBruteForce(random, index, items, 10));
+}
+
+void TestVpSpatialIndex::loadThenUpdate()
+{
+    VpSpatialIndex index;
+    QVector<VpSpatialIndex::Entry> items;
+
+    QRandomGenerator random(16);
+    for (int i = 0; i < 5000; i++)
+        items.append(randomBox(random, i));
+
+    // A bulk loaded tree answers like an incremental one, and stays
+    // correct as it is edited afterwards.
+    index.load(items);
+    QCOMPARE(index.getCount(), items.size());
+    QVERIFY(matchesBruteForce(random, index, items, 200));
+
+    // The bounds are those of all the items.
+    double xmin = items.at(0).m_xmin, ymin = items.at(0).m_ymin;
+    double xmax = items.at(0).m_xmax, ymax = items.at(0).m_ymax;
+    for (int i = 1; i < items.size(); i++)
+    {
+        xmin = qMin(xmin, items.at(i).m_xmin);
+        ymin = qMin(ymin, items.at(i).m_ymin);
+        xmax = qMax(xmax, items.at(i).m_xmax);
+        ymax = qMax(ymax, items.at(i).m_ymax);
+    }
+    QRectF bounds = index.getBounds();
+    QCOMPARE(bounds.left(), xmin);
+    QCOMPARE(bounds.top(), ymin);
+    QCOMPARE(bounds.right(), xmax);
+    QCOMPARE(bounds.bottom(), ymax);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        int k = random.bounded(items.size());
+        VpSpatialIndex::Entry entry = items.at(k);
+        QVERIFY(index.remove(entry.m_id, entry.m_xmin, entry.m_ymin, entry.m_xmax, entry.m_ymax));
+        items.remove(k);
+        if ((i % 2) == 0)
+        {
+            entry = randomBox(random, 5000 + i);
+            index.insert(entry.m_id, entry.m_xmin, entry.m_ymin, entry.m_xmax, entry.m_ymax);
+            items.append(entry);
+        }
+    }
+    QCOMPARE(index.getCount(), items.size());
+    QVERIFY(matchesBruteForce(random, index, items, 200));
+}
+
+QTEST_APPLESS_MAIN(TestVpSpatialIndex)
+#include "tst_vpspatialindex.moc"
@@ -0,0 +1,5 @@
+TARGET = tst_vpspatialindex
+
+include(../tests.pri)
+
+SOURCES += tst_vpspatialindex.cpp